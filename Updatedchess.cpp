@@ -3,630 +3,3910 @@
 #include <cctype>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 // #include <emscripten/emscripten.h>
 // #include <emscripten/bind.h>
 
 #define SIZE 8
+#define MAX_MOVES 256
 
-class ChessGame {
+// Hot-path counters. Build with -DCHESS_STATS to enable them; otherwise the
+// CHESS_STAT_* hooks expand to nothing. Each thread bumps its own counters
+// (no shared cache lines, no locked instructions) and getStats() sums them.
+enum ChessStat {
+    STAT_MOVE_CHECK,
+    STAT_SQUARE_UNDER_ATTACK,
+    STAT_WOULD_BE_IN_CHECK,
+    STAT_HAS_LEGAL_MOVES,
+    STAT_SQUARES_SCANNED,
+    STAT_MAKE_MOVE,
+    STAT_MAKE_MOVE_NS,
+    STAT_PAWN_HASH_PROBES,
+    STAT_PAWN_HASH_HITS,
+    STAT_COUNT
+};
+
+static const char* const chessStatNames[STAT_COUNT] = {
+    "moveCheck", "isSquareUnderAttack", "wouldBeInCheck", "hasLegalMoves",
+    "squaresScanned", "makeMove", "makeMoveNs", "pawnHashProbes", "pawnHashHits"
+};
+
+#ifdef CHESS_STATS
+#include <mutex>
+
+struct ChessStatsBlock {
+    std::atomic<uint64_t> counters[STAT_COUNT];
+    
+    ChessStatsBlock();
+    ~ChessStatsBlock();
+    
+    // Only the owning thread writes, so a relaxed load/store pair is enough
+    void add(int stat, uint64_t n) {
+        counters[stat].store(counters[stat].load(std::memory_order_relaxed) + n,
+                             std::memory_order_relaxed);
+    }
+};
+
+// Live per-thread blocks plus the totals of threads that have exited
+struct ChessStatsRegistry {
+    std::mutex lock;
+    std::vector<ChessStatsBlock*> blocks;
+    uint64_t retired[STAT_COUNT] = {};
+};
+
+inline ChessStatsRegistry& chessStatsRegistry() {
+    static ChessStatsRegistry registry;
+    return registry;
+}
+
+inline ChessStatsBlock::ChessStatsBlock() {
+    for (int i = 0; i < STAT_COUNT; i++) {
+        counters[i].store(0, std::memory_order_relaxed);
+    }
+    ChessStatsRegistry& registry = chessStatsRegistry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    registry.blocks.push_back(this);
+}
+
+inline ChessStatsBlock::~ChessStatsBlock() {
+    ChessStatsRegistry& registry = chessStatsRegistry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    for (int i = 0; i < STAT_COUNT; i++) {
+        registry.retired[i] += counters[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < registry.blocks.size(); i++) {
+        if (registry.blocks[i] == this) {
+            registry.blocks.erase(registry.blocks.begin() + i);
+            break;
+        }
+    }
+}
+
+inline ChessStatsBlock& chessStatsLocal() {
+    static thread_local ChessStatsBlock block;
+    return block;
+}
+
+// Adds the lifetime of the enclosing scope, in nanoseconds, to a counter
+struct ChessStatTimer {
+    int stat;
+    std::chrono::steady_clock::time_point start;
+    
+    explicit ChessStatTimer(int s) : stat(s), start(std::chrono::steady_clock::now()) {}
+    ~ChessStatTimer() {
+        chessStatsLocal().add(stat, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+};
+
+#define CHESS_STAT_ADD(stat, n) chessStatsLocal().add(stat, n)
+#define CHESS_STAT_TIMER(stat) ChessStatTimer chessStatTimer_(stat)
+#else
+#define CHESS_STAT_ADD(stat, n) ((void)0)
+#define CHESS_STAT_TIMER(stat) ((void)0)
+#endif
+
+// Timeline tracer. Build with -DCHESS_TRACE to enable it; otherwise the
+// CHESS_TRACE_* hooks expand to nothing. A span records the lifetime of its
+// scope into the calling thread's ring buffer, which only that thread
+// writes, and ChessGame::getTrace() renders every buffer as Chrome trace
+// event JSON (chrome://tracing, ui.perfetto.dev). Full rings overwrite
+// their oldest spans.
+#ifdef CHESS_TRACE
+#include <mutex>
+
+#define CHESS_TRACE_CAPACITY (1 << 16)   // Spans kept per thread, a power of two
+
+struct ChessTraceEvent {
+    const char* name;          // A string literal
+    int64_t arg;               // Shown as args.value unless TRACE_NO_ARG
+    uint64_t startNs;
+    uint64_t durationNs;
+};
+
+static const int64_t TRACE_NO_ARG = INT64_MIN;
+
+// A ring slot, read by getTrace while its owner may be rewriting it. Each
+// field is atomic and the slot is guarded like a seqlock: sequence is 0
+// while the fields change and span number + 1 once they are complete. A
+// field read from a newer span (acquire, pairing with its release store)
+// makes the reader's second sequence load see 0 or later, so a reader that
+// sees the same sequence before and after copying has a whole span.
+struct ChessTraceSlot {
+    std::atomic<uint64_t> sequence;
+    std::atomic<const char*> name;
+    std::atomic<int64_t> arg;
+    std::atomic<uint64_t> startNs;
+    std::atomic<uint64_t> durationNs;
+};
+
+struct ChessTraceBuffer {
+    int tid;
+    std::atomic<uint64_t> head;    // Spans ever written
+    ChessTraceSlot slots[CHESS_TRACE_CAPACITY];
+    
+    explicit ChessTraceBuffer(int id) : tid(id), head(0) {
+        for (ChessTraceSlot& slot : slots) {
+            slot.sequence.store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    void record(const char* name, int64_t arg, uint64_t startNs, uint64_t durationNs) {
+        uint64_t n = head.load(std::memory_order_relaxed);
+        ChessTraceSlot& slot = slots[n & (CHESS_TRACE_CAPACITY - 1)];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        slot.name.store(name, std::memory_order_release);
+        slot.arg.store(arg, std::memory_order_release);
+        slot.startNs.store(startNs, std::memory_order_release);
+        slot.durationNs.store(durationNs, std::memory_order_release);
+        slot.sequence.store(n + 1, std::memory_order_release);
+        head.store(n + 1, std::memory_order_release);
+    }
+    
+    // Copy span n into event; false if it is being or has been overwritten
+    bool read(uint64_t n, ChessTraceEvent& event) const {
+        const ChessTraceSlot& slot = slots[n & (CHESS_TRACE_CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != n + 1) {
+            return false;
+        }
+        event.name = slot.name.load(std::memory_order_acquire);
+        event.arg = slot.arg.load(std::memory_order_acquire);
+        event.startNs = slot.startNs.load(std::memory_order_acquire);
+        event.durationNs = slot.durationNs.load(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == n + 1;
+    }
+};
+
+// Every buffer ever created. Buffers outlive their threads so their spans
+// can still be dumped, and are handed to new threads once released.
+struct ChessTraceRegistry {
+    std::mutex lock;
+    std::vector<ChessTraceBuffer*> buffers;
+    std::vector<ChessTraceBuffer*> released;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+inline ChessTraceRegistry& chessTraceRegistry() {
+    static ChessTraceRegistry registry;
+    return registry;
+}
+
+// Holds the calling thread's buffer for the thread's lifetime
+struct ChessTraceLease {
+    ChessTraceBuffer* buffer;
+    
+    ChessTraceLease() {
+        ChessTraceRegistry& registry = chessTraceRegistry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        if (registry.released.empty()) {
+            buffer = new ChessTraceBuffer((int)registry.buffers.size() + 1);
+            registry.buffers.push_back(buffer);
+        } else {
+            buffer = registry.released.back();
+            registry.released.pop_back();
+        }
+    }
+    
+    ~ChessTraceLease() {
+        ChessTraceRegistry& registry = chessTraceRegistry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        registry.released.push_back(buffer);
+    }
+};
+
+inline ChessTraceBuffer& chessTraceLocal() {
+    static thread_local ChessTraceLease lease;
+    return *lease.buffer;
+}
+
+inline uint64_t chessTraceNow() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - chessTraceRegistry().epoch).count();
+}
+
+// Records the enclosing scope as one span
+struct ChessTraceScope {
+    const char* name;
+    int64_t arg;
+    uint64_t start;
+    
+    explicit ChessTraceScope(const char* n, int64_t a = TRACE_NO_ARG) : name(n), arg(a), start(chessTraceNow()) {}
+    ~ChessTraceScope() {
+        chessTraceLocal().record(name, arg, start, chessTraceNow() - start);
+    }
+};
+
+#define CHESS_TRACE_SCOPE(name) ChessTraceScope chessTraceScope_(name)
+#define CHESS_TRACE_SCOPE_ARG(name, arg) ChessTraceScope chessTraceScope_(name, arg)
+#else
+#define CHESS_TRACE_SCOPE(name) ((void)0)
+#define CHESS_TRACE_SCOPE_ARG(name, arg) ((void)0)
+#endif
+
+// Board, move rules and undo/redo, with the hooks above compiled in
+#include "chess_core.h"
+
+// Index layout shared by the bitbases and tablebases. The white king fixes
+// the symmetry: a position is mirrored so that king stands on files a-d and,
+// without pawns, inside the a1-d1-d4 triangle. The index is the king's slot
+// there (32 with pawns, 10 without), offset by the side to move, then 64
+// squares for each other man.
+struct EndgameIndex {
+    static int kingSlots(bool pawns) {
+        return pawns ? 32 : 10;
+    }
+    
+    // Positions in a table of men men, both kings included
+    static uint64_t size(int men, bool pawns) {
+        return 2ULL * kingSlots(pawns) << (6 * (men - 1));
+    }
+    
+    // Mirror squares (row * SIZE + col, white king first) into the stored
+    // part of the table
+    static void mirror(int* squares, int count, bool pawns) {
+        if (squares[0] % SIZE > 3) {
+            for (int i = 0; i < count; i++) squares[i] ^= 7;
+        }
+        if (pawns) {
+            return;   // Pawns keep their direction
+        }
+        if (7 - squares[0] / SIZE > 3) {
+            for (int i = 0; i < count; i++) squares[i] ^= 56;
+        }
+        if (7 - squares[0] / SIZE > squares[0] % SIZE) {
+            for (int i = 0; i < count; i++) {
+                int rank = 7 - squares[i] / SIZE, file = squares[i] % SIZE;
+                squares[i] = (7 - file) * SIZE + rank;
+            }
+        }
+    }
+    
+    static int kingSlot(int king, bool pawns) {
+        int file = king % SIZE;
+        return pawns ? (king / SIZE) * 4 + file : file * (file + 1) / 2 + (7 - king / SIZE);
+    }
+    
+    static int slotSquare(int slot, bool pawns) {
+        if (pawns) {
+            return (slot / 4) * SIZE + slot % 4;
+        }
+        int file = 0;
+        while ((file + 1) * (file + 2) / 2 <= slot) file++;
+        return (7 - (slot - file * (file + 1) / 2)) * SIZE + file;
+    }
+    
+    // Index of squares already mirrored
+    static uint64_t index(const int* squares, int count, bool whiteToMove, bool pawns) {
+        uint64_t idx = (whiteToMove ? 0 : kingSlots(pawns)) + kingSlot(squares[0], pawns);
+        for (int i = 1; i < count; i++) {
+            idx = idx * 64 + squares[i];
+        }
+        return idx;
+    }
+    
+    // Squares of an index; returns whether White is to move
+    static bool decode(uint64_t idx, int count, bool pawns, int* squares) {
+        for (int i = count - 1; i >= 1; i--) {
+            squares[i] = idx & 63;
+            idx >>= 6;
+        }
+        squares[0] = slotSquare((int)(idx % kingSlots(pawns)), pawns);
+        return idx < (uint64_t)kingSlots(pawns);
+    }
+};
+
+// Win/draw bitbases for KPK, KRK, KQK and KBNK, built offline by
+// chess_bitbase_gen. Positions are normalized so the side with material is
+// White; one bit per position says whether White wins. Positions are
+// indexed by EndgameIndex, so only the stored part of each table takes
+// space.
+enum BitbaseTable { BB_KPK, BB_KRK, BB_KQK, BB_KBNK, BB_TABLE_COUNT };
+
+struct Bitbases {
+    static const char* tableName(int table) {
+        static const char* const names[BB_TABLE_COUNT] = {"KPK", "KRK", "KQK", "KBNK"};
+        return names[table];
+    }
+    
+    // White's pieces besides the king, in index order
+    static const char* tablePieces(int table) {
+        static const char* const pieces[BB_TABLE_COUNT] = {"P", "R", "Q", "BN"};
+        return pieces[table];
+    }
+    
+    static int pieceCount(int table) {
+        return (int)strlen(tablePieces(table));
+    }
+    
+    // Positions (= bits) in a table
+    static uint64_t tableSize(int table) {
+        return EndgameIndex::size(2 + pieceCount(table), table == BB_KPK);
+    }
+    
+    // Table index of a position. Squares are row * SIZE + col and are
+    // mirrored into the stored part of the table first.
+    static uint32_t index(int table, bool whiteToMove, int whiteKing, int blackKing, const int* pieces) {
+        int squares[4] = {whiteKing, blackKing, pieces[0], table == BB_KBNK ? pieces[1] : 0};
+        int count = 2 + pieceCount(table);
+        EndgameIndex::mirror(squares, count, table == BB_KPK);
+        return (uint32_t)EndgameIndex::index(squares, count, whiteToMove, table == BB_KPK);
+    }
+    
+    std::vector<uint64_t> bits[BB_TABLE_COUNT];
+    
+    bool has(int table) const {
+        return !bits[table].empty();
+    }
+    
+    bool whiteWins(int table, uint32_t idx) const {
+        return (bits[table][idx >> 6] >> (idx & 63)) & 1;
+    }
+    
+    // File layout: "CBB2", table count, then per table its id, word count
+    // and the packed bits (native byte order)
+    bool load(const char* path) {
+        FILE* file = fopen(path, "rb");
+        if (!file) {
+            return false;
+        }
+        
+        char magic[4];
+        uint32_t tables = 0;
+        bool ok = fread(magic, 1, 4, file) == 4 && memcmp(magic, "CBB2", 4) == 0 &&
+                  fread(&tables, sizeof(tables), 1, file) == 1;
+        for (uint32_t t = 0; ok && t < tables; t++) {
+            uint32_t table;
+            uint64_t words;
+            ok = fread(&table, sizeof(table), 1, file) == 1 && fread(&words, sizeof(words), 1, file) == 1 &&
+                 table < BB_TABLE_COUNT && words == tableSize(table) / 64;
+            if (ok) {
+                bits[table].resize(words);
+                ok = fread(bits[table].data(), sizeof(uint64_t), words, file) == words;
+            }
+        }
+        fclose(file);
+        
+        if (!ok) {
+            for (int t = 0; t < BB_TABLE_COUNT; t++) bits[t].clear();
+        }
+        return ok;
+    }
+    
+    bool save(const char* path) const {
+        FILE* file = fopen(path, "wb");
+        if (!file) {
+            return false;
+        }
+        
+        uint32_t tables = 0;
+        for (int t = 0; t < BB_TABLE_COUNT; t++) tables += has(t);
+        bool ok = fwrite("CBB2", 1, 4, file) == 4 && fwrite(&tables, sizeof(tables), 1, file) == 1;
+        for (uint32_t t = 0; ok && t < BB_TABLE_COUNT; t++) {
+            if (!has(t)) continue;
+            uint64_t words = bits[t].size();
+            ok = fwrite(&t, sizeof(t), 1, file) == 1 && fwrite(&words, sizeof(words), 1, file) == 1 &&
+                 fwrite(bits[t].data(), sizeof(uint64_t), words, file) == words;
+        }
+        return fclose(file) == 0 && ok;
+    }
+};
+
+// Process-wide bitbases used by ChessGame::probeBitbase
+inline Bitbases& chessBitbases() {
+    static Bitbases bitbases;
+    return bitbases;
+}
+
+// Endgame tablebases of up to TB_MAX_PIECES men, one file per material split
+// (e.g. KRPvKR.ctb) built by chess_tb_gen. Files are mapped shared and
+// read-only, so every process and search thread reads the same pages with no
+// allocation or locking per probe. Each position is one byte for the side to
+// move: 0 draw, 1..127 a win and 128 + n a loss, where n is the number of
+// plies until the winning side converts (captures, promotes or mates), capped
+// at 127. Only the White-major side of each split is stored; the other is
+// probed color-flipped. Load tables before starting any search.
+#define TB_MAX_PIECES 5
+
+// A position in table order: white king, black king, then White's and
+// Black's men in "QRBNP" order
+struct TablebasePosition {
+    int count;
+    char pieces[TB_MAX_PIECES];
+    int squares[TB_MAX_PIECES];
+    bool whiteToMove;
+    uint64_t key;
+};
+
+struct TablebaseFile {
+    uint64_t key;
+    bool pawns;
+    const uint8_t* entries;
+    uint64_t size;
+    void* mapping;
+    size_t mappingLength;
+};
+
+// On-disk header; the entries follow at byte 64
+struct TablebaseHeader {
+    char magic[4];
+    uint32_t men;
+    uint64_t key;
+    uint64_t size;
+    uint8_t reserved[40];
+};
+
+struct Tablebases {
+    std::vector<TablebaseFile> files;   // Sorted by material key
+    int maxMen = 0;
+    
+    ~Tablebases() {
+        for (const TablebaseFile& file : files) {
+            munmap(file.mapping, file.mappingLength);
+        }
+    }
+    
+    // Material keys hold a 4-bit count per piece type, White's in the low
+    // 20 bits and Black's in the high 20
+    static int pieceSlot(char piece) {
+        static const char order[] = "QRBNPqrbnp";
+        const char* found = strchr(order, piece);
+        return found ? (int)(found - order) : -1;
+    }
+    
+    static uint64_t flipKey(uint64_t key) {
+        return ((key & 0xFFFFF) << 20) | (key >> 20);
+    }
+    
+    static int sideValue(uint64_t side) {
+        static const int values[5] = {9, 5, 3, 3, 1};
+        int value = 0;
+        for (int t = 0; t < 5; t++) value += values[t] * (int)((side >> (4 * t)) & 15);
+        return value;
+    }
+    
+    // Stored splits have White at least as strong as Black
+    static bool isCanonical(uint64_t key) {
+        int white = sideValue(key & 0xFFFFF), black = sideValue(key >> 20);
+        return white > black || (white == black && (key & 0xFFFFF) >= (key >> 20));
+    }
+    
+    static bool hasPawns(uint64_t key) {
+        return ((key >> 16) & 15) || ((key >> 36) & 15);
+    }
+    
+    static int menCount(uint64_t key) {
+        int men = 2;
+        for (int t = 0; t < 10; t++) men += (key >> (4 * t)) & 15;
+        return men;
+    }
+    
+    // Bare kings, or kings and a single minor piece, can't be won
+    static bool isDeadDraw(uint64_t key) {
+        const uint64_t minors = (0xFFULL << 8) | (0xFFULL << 28);   // B and N counts of each side
+        return (key & ~minors) == 0 && menCount(key) <= 3;
+    }
+    
+    // "KRPvKR" <-> key
+    static std::string materialName(uint64_t key) {
+        static const char order[] = "QRBNP";
+        std::string name = "K";
+        for (int side = 0; side < 2; side++) {
+            for (int t = 0; t < 5; t++) {
+                name.append((key >> (4 * (side * 5 + t))) & 15, order[t]);
+            }
+            if (side == 0) name += "vK";
+        }
+        return name;
+    }
+    
+    static bool parseMaterial(const std::string& name, uint64_t& key) {
+        size_t split = name.find("vK");
+        if (name.size() < 3 || name[0] != 'K' || split == std::string::npos) {
+            return false;
+        }
+        key = 0;
+        for (size_t i = 1; i < name.size(); i++) {
+            if (i == split || i == split + 1) continue;
+            int slot = pieceSlot(name[i]);
+            if (slot < 0 || slot >= 5) return false;
+            key += 1ULL << (4 * (slot + (i > split ? 5 : 0)));
+        }
+        return menCount(key) <= TB_MAX_PIECES;
+    }
+    
+    // Positions stored in a file (see EndgameIndex)
+    static uint64_t tableSize(int men, bool pawns) {
+        return EndgameIndex::size(men, pawns);
+    }
+    
+    // Put men given in any order into table order, flipping colors when the
+    // position's split is stored the other way round
+    static void normalize(const char* pieces, const int* squares, int count, bool whiteToMove, TablebasePosition& position) {
+        uint64_t key = 0;
+        for (int i = 0; i < count; i++) {
+            int slot = pieceSlot(pieces[i]);
+            if (slot >= 0) key += 1ULL << (4 * slot);
+        }
+        bool flip = !isCanonical(key);
+        
+        char flipped[TB_MAX_PIECES];
+        int moved[TB_MAX_PIECES];
+        for (int i = 0; i < count; i++) {
+            flipped[i] = !flip ? pieces[i] : (isupper(pieces[i]) ? tolower(pieces[i]) : toupper(pieces[i]));
+            moved[i] = flip ? squares[i] ^ 56 : squares[i];
+            if (flipped[i] == 'K' || flipped[i] == 'k') {
+                int side = (flipped[i] == 'K') ? 0 : 1;
+                position.pieces[side] = flipped[i];
+                position.squares[side] = moved[i];
+            }
+        }
+        
+        position.count = 2;
+        position.whiteToMove = (whiteToMove != flip);
+        position.key = flip ? flipKey(key) : key;
+        for (int slot = 0; slot < 10; slot++) {
+            for (int i = 0; i < count; i++) {
+                if (pieceSlot(flipped[i]) == slot) {
+                    position.pieces[position.count] = flipped[i];
+                    position.squares[position.count++] = moved[i];
+                }
+            }
+        }
+    }
+    
+    // File index of a normalized position; symmetric positions are mirrored
+    // onto the stored part first
+    static uint64_t index(const TablebasePosition& position, bool pawns) {
+        int squares[TB_MAX_PIECES];
+        int count = position.count;
+        memcpy(squares, position.squares, sizeof(int) * count);
+        EndgameIndex::mirror(squares, count, pawns);
+        
+        // Identical men go in ascending square order so a position has a
+        // single index
+        for (int i = 3; i < count; i++) {
+            for (int j = i; j > 2 && position.pieces[j - 1] == position.pieces[i] && squares[j - 1] > squares[j]; j--) {
+                std::swap(squares[j - 1], squares[j]);
+            }
+        }
+        
+        return EndgameIndex::index(squares, count, position.whiteToMove, pawns);
+    }
+    
+    const TablebaseFile* find(uint64_t key) const {
+        auto it = std::lower_bound(files.begin(), files.end(), key,
+                                   [](const TablebaseFile& file, uint64_t k) { return file.key < k; });
+        return (it != files.end() && it->key == key) ? &*it : nullptr;
+    }
+    
+    // Entry for the side to move, or -1 when no table covers the position.
+    // Bare kings and a lone minor piece are drawn without a table.
+    int probe(const char* pieces, const int* squares, int count, bool whiteToMove) const {
+        TablebasePosition position;
+        normalize(pieces, squares, count, whiteToMove, position);
+        if (isDeadDraw(position.key)) {
+            return 0;
+        }
+        const TablebaseFile* file = find(position.key);
+        if (!file) {
+            return -1;
+        }
+        return file->entries[index(position, file->pawns)];
+    }
+    
+    bool add(const char* path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        void* mapping = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(TablebaseHeader)) {
+            mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+        
+        const TablebaseHeader* header = (const TablebaseHeader*)mapping;
+        TablebaseFile file = {header->key, hasPawns(header->key), (const uint8_t*)mapping + sizeof(TablebaseHeader),
+                              header->size, mapping, (size_t)info.st_size};
+        bool ok = memcmp(header->magic, "CTB1", 4) == 0 && header->men <= TB_MAX_PIECES &&
+                  (int)header->men == menCount(header->key) && isCanonical(header->key) &&
+                  header->size == tableSize(header->men, file.pawns) &&
+                  (size_t)info.st_size == sizeof(TablebaseHeader) + header->size && !find(header->key);
+        if (!ok) {
+            munmap(mapping, info.st_size);
+            return false;
+        }
+        
+        // Probes hit scattered pages; don't read ahead around them
+        madvise(mapping, info.st_size, MADV_RANDOM);
+        files.insert(std::upper_bound(files.begin(), files.end(), file.key,
+                                      [](uint64_t k, const TablebaseFile& f) { return k < f.key; }), file);
+        maxMen = std::max(maxMen, (int)header->men);
+        return true;
+    }
+    
+    // Map every *.ctb file in a directory; returns how many were added
+    int loadDirectory(const char* directory) {
+        DIR* dir = opendir(directory);
+        if (!dir) {
+            return 0;
+        }
+        int added = 0;
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".ctb") == 0) {
+                added += add((std::string(directory) + "/" + name).c_str());
+            }
+        }
+        closedir(dir);
+        return added;
+    }
+    
+    static bool write(const char* path, uint64_t key, const std::vector<uint8_t>& entries) {
+        FILE* file = fopen(path, "wb");
+        if (!file) {
+            return false;
+        }
+        TablebaseHeader header = {};
+        memcpy(header.magic, "CTB1", 4);
+        header.men = menCount(key);
+        header.key = key;
+        header.size = entries.size();
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(entries.data(), 1, entries.size(), file) == entries.size();
+        return fclose(file) == 0 && ok;
+    }
+};
+
+// Process-wide tablebases used by ChessGame::probeWDL / probeDTZ
+inline Tablebases& chessTablebases() {
+    static Tablebases tablebases;
+    return tablebases;
+}
+
+// Opening book: a file of BookEntry records sorted by position hash (see
+// ChessGame::getHashKey), built by chess_book_build. It is mapped read-only
+// and used in place; a lookup is a binary search with no parsing or
+// allocation.
+struct BookEntry {
+    uint64_t key;
+    uint16_t move;      // Packed as in ChessGame::encodeMove
+    uint16_t weight;    // Relative frequency among the position's moves
+    uint32_t games;     // Games the move was played in
+};
+
+// On-disk header; the entries follow at byte 16
+struct BookHeader {
+    char magic[4];
+    uint32_t reserved;
+    uint64_t count;
+};
+
+struct OpeningBook {
+    const BookEntry* entries = nullptr;
+    uint64_t count = 0;
+    void* mapping = nullptr;
+    size_t mappingLength = 0;
+    
+    ~OpeningBook() {
+        close();
+    }
+    
+    void close() {
+        if (mapping) {
+            munmap(mapping, mappingLength);
+        }
+        entries = nullptr;
+        count = 0;
+        mapping = nullptr;
+    }
+    
+    bool open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        void* mapped = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(BookHeader)) {
+            mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        
+        const BookHeader* header = (const BookHeader*)mapped;
+        if (memcmp(header->magic, "CBK1", 4) != 0 ||
+            (size_t)info.st_size != sizeof(BookHeader) + header->count * sizeof(BookEntry)) {
+            munmap(mapped, info.st_size);
+            return false;
+        }
+        mapping = mapped;
+        mappingLength = info.st_size;
+        entries = (const BookEntry*)((const char*)mapped + sizeof(BookHeader));
+        count = header->count;
+        return true;
+    }
+    
+    // First entry for key, or count when there is none. The loop halves the
+    // range with a conditional add instead of a branch, so it runs the same
+    // log2(count) steps for every key.
+    uint64_t lowerBound(uint64_t key) const {
+        if (count == 0) {
+            return 0;
+        }
+        const BookEntry* base = entries;
+        uint64_t length = count;
+        while (length > 1) {
+            uint64_t half = length / 2;
+            base += (base[half - 1].key < key) ? half : 0;
+            length -= half;
+        }
+        uint64_t found = (base - entries) + (base->key < key);
+        return (found < count && entries[found].key == key) ? found : count;
+    }
+    
+    static bool write(const char* path, const std::vector<BookEntry>& sorted) {
+        FILE* file = fopen(path, "wb");
+        if (!file) {
+            return false;
+        }
+        BookHeader header = {};
+        memcpy(header.magic, "CBK1", 4);
+        header.count = sorted.size();
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(sorted.data(), sizeof(BookEntry), sorted.size(), file) == sorted.size();
+        return fclose(file) == 0 && ok;
+    }
+};
+
+// Process-wide opening book used by ChessGame::getBookMoves
+inline OpeningBook& chessOpeningBook() {
+    static OpeningBook book;
+    return book;
+}
+
+// Evaluation weights in centipawns, indexed by EvalWeight. The defaults are
+// the hand-set values; chess_tune fits new ones to labelled positions and
+// writes a weights file for ChessGame::loadEvalWeights.
+enum EvalWeight {
+    EW_MATERIAL = 0,                       // P, N, B, R, Q, K
+    EW_PST = EW_MATERIAL + 6,              // 64 squares per piece type, White's view, rank 8 first
+    EW_DOUBLED_PAWN = EW_PST + 6 * 64,     // Per extra pawn on a file
+    EW_ISOLATED_PAWN,
+    EW_PASSED_PAWN,                        // 8 entries, by ranks advanced
+    EW_SHIELD_NEAR = EW_PASSED_PAWN + 8,   // Shield pawn right in front of the king
+    EW_SHIELD_FAR,                         // ... or one square further
+    EW_SHIELD_MISSING,                     // No shield pawn on the file
+    EW_COUNT
+};
+
+struct EvalWeights {
+    int values[EW_COUNT];
+    
+    // Named groups of the weights file, one line each: "name v1 v2 ..."
+    struct Group {
+        const char* name;
+        int first;
+        int count;
+    };
+    
+    static const Group* groups(int& count) {
+        static const Group table[] = {
+            {"material", EW_MATERIAL, 6},
+            {"pst_pawn", EW_PST + 0 * 64, 64},
+            {"pst_knight", EW_PST + 1 * 64, 64},
+            {"pst_bishop", EW_PST + 2 * 64, 64},
+            {"pst_rook", EW_PST + 3 * 64, 64},
+            {"pst_queen", EW_PST + 4 * 64, 64},
+            {"pst_king", EW_PST + 5 * 64, 64},
+            {"doubled_pawn", EW_DOUBLED_PAWN, 1},
+            {"isolated_pawn", EW_ISOLATED_PAWN, 1},
+            {"passed_pawn", EW_PASSED_PAWN, 8},
+            {"shield", EW_SHIELD_NEAR, 3},
+        };
+        count = sizeof(table) / sizeof(table[0]);
+        return table;
+    }
+    
+    EvalWeights() {
+        // Piece-square tables from White's side, rank 8 first (row 0)
+        static const int pawnTable[64] = {
+              0,  0,  0,  0,  0,  0,  0,  0,
+             50, 50, 50, 50, 50, 50, 50, 50,
+             10, 10, 20, 30, 30, 20, 10, 10,
+              5,  5, 10, 25, 25, 10,  5,  5,
+              0,  0,  0, 20, 20,  0,  0,  0,
+              5, -5,-10,  0,  0,-10, -5,  5,
+              5, 10, 10,-20,-20, 10, 10,  5,
+              0,  0,  0,  0,  0,  0,  0,  0
+        };
+        static const int knightTable[64] = {
+            -50,-40,-30,-30,-30,-30,-40,-50,
+            -40,-20,  0,  0,  0,  0,-20,-40,
+            -30,  0, 10, 15, 15, 10,  0,-30,
+            -30,  5, 15, 20, 20, 15,  5,-30,
+            -30,  0, 15, 20, 20, 15,  0,-30,
+            -30,  5, 10, 15, 15, 10,  5,-30,
+            -40,-20,  0,  5,  5,  0,-20,-40,
+            -50,-40,-30,-30,-30,-30,-40,-50
+        };
+        static const int bishopTable[64] = {
+            -20,-10,-10,-10,-10,-10,-10,-20,
+            -10,  0,  0,  0,  0,  0,  0,-10,
+            -10,  0,  5, 10, 10,  5,  0,-10,
+            -10,  5,  5, 10, 10,  5,  5,-10,
+            -10,  0, 10, 10, 10, 10,  0,-10,
+            -10, 10, 10, 10, 10, 10, 10,-10,
+            -10,  5,  0,  0,  0,  0,  5,-10,
+            -20,-10,-10,-10,-10,-10,-10,-20
+        };
+        static const int rookTable[64] = {
+              0,  0,  0,  0,  0,  0,  0,  0,
+              5, 10, 10, 10, 10, 10, 10,  5,
+             -5,  0,  0,  0,  0,  0,  0, -5,
+             -5,  0,  0,  0,  0,  0,  0, -5,
+             -5,  0,  0,  0,  0,  0,  0, -5,
+             -5,  0,  0,  0,  0,  0,  0, -5,
+             -5,  0,  0,  0,  0,  0,  0, -5,
+              0,  0,  0,  5,  5,  0,  0,  0
+        };
+        static const int queenTable[64] = {
+            -20,-10,-10, -5, -5,-10,-10,-20,
+            -10,  0,  0,  0,  0,  0,  0,-10,
+            -10,  0,  5,  5,  5,  5,  0,-10,
+             -5,  0,  5,  5,  5,  5,  0, -5,
+              0,  0,  5,  5,  5,  5,  0, -5,
+            -10,  5,  5,  5,  5,  5,  0,-10,
+            -10,  0,  5,  0,  0,  0,  0,-10,
+            -20,-10,-10, -5, -5,-10,-10,-20
+        };
+        static const int kingTable[64] = {
+            -30,-40,-40,-50,-50,-40,-40,-30,
+            -30,-40,-40,-50,-50,-40,-40,-30,
+            -30,-40,-40,-50,-50,-40,-40,-30,
+            -30,-40,-40,-50,-50,-40,-40,-30,
+            -20,-30,-30,-40,-40,-30,-30,-20,
+            -10,-20,-20,-20,-20,-20,-20,-10,
+             20, 20,  0,  0,  0,  0, 20, 20,
+             20, 30, 10,  0,  0, 10, 30, 20
+        };
+        static const int material[6] = {100, 320, 330, 500, 900, 0};
+        static const int passed[8] = {0, 10, 15, 25, 40, 60, 90, 0};
+        static const int* const tables[6] = {pawnTable, knightTable, bishopTable, rookTable, queenTable, kingTable};
+        
+        memcpy(values + EW_MATERIAL, material, sizeof(material));
+        for (int t = 0; t < 6; t++) {
+            memcpy(values + EW_PST + t * 64, tables[t], 64 * sizeof(int));
+        }
+        values[EW_DOUBLED_PAWN] = -10;
+        values[EW_ISOLATED_PAWN] = -15;
+        memcpy(values + EW_PASSED_PAWN, passed, sizeof(passed));
+        values[EW_SHIELD_NEAR] = 12;
+        values[EW_SHIELD_FAR] = 6;
+        values[EW_SHIELD_MISSING] = -10;
+    }
+    
+    // Every group must be present with all its values; on failure the
+    // weights are left unchanged
+    bool load(const char* path) {
+        FILE* file = fopen(path, "r");
+        if (!file) {
+            return false;
+        }
+        int groupCount;
+        const Group* table = groups(groupCount);
+        int loaded[EW_COUNT];
+        std::vector<bool> seen(groupCount, false);
+        char name[32];
+        bool ok = true;
+        while (ok && fscanf(file, " %31s", name) == 1) {
+            if (name[0] == '#') {
+                int ch;
+                while ((ch = fgetc(file)) != EOF && ch != '\n') {}
+                continue;
+            }
+            int g = 0;
+            while (g < groupCount && strcmp(table[g].name, name) != 0) g++;
+            ok = g < groupCount;
+            for (int i = 0; ok && i < table[g].count; i++) {
+                ok = fscanf(file, "%d", &loaded[table[g].first + i]) == 1;
+            }
+            if (ok) seen[g] = true;
+        }
+        fclose(file);
+        if (!ok || std::count(seen.begin(), seen.end(), false) > 0) {
+            return false;
+        }
+        memcpy(values, loaded, sizeof(values));
+        return true;
+    }
+    
+    bool save(const char* path) const {
+        FILE* file = fopen(path, "w");
+        if (!file) {
+            return false;
+        }
+        int groupCount;
+        const Group* table = groups(groupCount);
+        fputs("# Evaluation weights (centipawns); tables are rank 8 first\n", file);
+        for (int g = 0; g < groupCount; g++) {
+            fputs(table[g].name, file);
+            for (int i = 0; i < table[g].count; i++) {
+                fprintf(file, "%s%d", (table[g].count == 64 && i % 8 == 0) ? "\n   " : " ", values[table[g].first + i]);
+            }
+            fputc('\n', file);
+        }
+        return fclose(file) == 0;
+    }
+};
+
+// Process-wide evaluation weights used by every Searcher
+inline EvalWeights& chessEvalWeights() {
+    static EvalWeights weights;
+    return weights;
+}
+
+// Game session snapshot (ChessGame::serialize): a GameSnapshotHeader, then
+// moveCount GameSnapshotMove records covering the whole history, redo tail
+// included. Fields are fixed-width in host byte order, so a snapshot is
+// restored by copying, never by parsing or replaying moves.
+#define GAME_SNAPSHOT_VERSION 2
+
+struct GameSnapshotHeader {
+    char magic[4];              // "CGSS"
+    uint32_t version;           // GAME_SNAPSHOT_VERSION
+    int32_t currentMoveIndex;   // -1 before the first move
+    uint32_t moveCount;
+    uint32_t baseHalfmoveClock; // FEN counters where the history starts
+    uint32_t baseMoveNumber;
+    char board[SIZE * SIZE];    // Rank 8 first, as getBoardState
+    char currentPlayer;
+    uint8_t reserved[7];
+};
+
+struct GameSnapshotMove {
+    uint16_t move;              // Packed as in ChessGame::encodeMove
+    char movedPiece;
+    char capturedPiece;
+    char promotedTo;            // ' ' unless the move promoted
+    uint8_t flags;              // 1 = gave check, 2 = gave checkmate
+};
+
+// The engine build of the shared core (chess_core.h): legal moves only,
+// auto-queening, full history, plus hashing, search and everything else
+class ChessGame : public ChessCore<RejectSelfCheck, PromoteToQueen, KeepHistory> {
+    friend class Searcher;
+    friend class MovePicker;
+    friend struct Evaluation;
+    
+    typedef ChessCore<RejectSelfCheck, PromoteToQueen, KeepHistory> Core;
+    
+private:
+    bool inCheck;
+    
+    // FEN halfmove clock and fullmove number of the position the move
+    // history starts from, so getFEN can count on from a loaded FEN
+    int baseHalfmoveClock;
+    int baseMoveNumber;
+    
+    // Zobrist hash of the position, updated incrementally with every move
+    uint64_t hashKey;
+    
+    // Zobrist hash of the pawns alone, for the search's pawn hash table
+    uint64_t pawnKey;
+    
+    // Zobrist keys: one per piece and square plus one for the side to move,
+    // drawn from a fixed-seed generator so hashes are the same on every run
+    struct ZobristTable {
+        uint64_t pieceSquare[12][SIZE * SIZE];
+        uint64_t blackToMove;
+        
+        ZobristTable() {
+            uint64_t seed = 0x2545F4914F6CDD1DULL;
+            auto next = [&seed]() {
+                seed ^= seed >> 12;
+                seed ^= seed << 25;
+                seed ^= seed >> 27;
+                return seed * 0x2545F4914F6CDD1DULL;
+            };
+            for (int p = 0; p < 12; p++) {
+                for (int sq = 0; sq < SIZE * SIZE; sq++) {
+                    pieceSquare[p][sq] = next();
+                }
+            }
+            blackToMove = next();
+        }
+    };
+    
+    static const ZobristTable& zobrist() {
+        static const ZobristTable table;
+        return table;
+    }
+    
+    // Index of a piece character in the Zobrist table
+    static int pieceIndex(char piece) {
+        static const char pieces[] = "PNBRQKpnbrqk";
+        return (int)(strchr(pieces, piece) - pieces);
+    }
+    
+    static uint64_t pieceKey(char piece, int row, int col) {
+        return zobrist().pieceSquare[pieceIndex(piece)][row * SIZE + col];
+    }
+    
+    uint64_t computeHash() const {
+        uint64_t key = (currentPlayer == 'b') ? zobrist().blackToMove : 0;
+        for (int r = 0; r < SIZE; r++) {
+            for (int c = 0; c < SIZE; c++) {
+                if (board[r][c] != ' ') {
+                    key ^= pieceKey(board[r][c], r, c);
+                }
+            }
+        }
+        return key;
+    }
+    
+    uint64_t computePawnHash() const {
+        uint64_t key = 0;
+        for (int r = 0; r < SIZE; r++) {
+            for (int c = 0; c < SIZE; c++) {
+                if (toupper(board[r][c]) == 'P') {
+                    key ^= pieceKey(board[r][c], r, c);
+                }
+            }
+        }
+        return key;
+    }
+    
+    // Hash difference between the positions before and after a move; the
+    // same XOR applies it and takes it back
+    static uint64_t moveKeyDelta(const MoveRecord& move) {
+        uint64_t delta = zobrist().blackToMove ^ pieceKey(move.movedPiece, move.fromRow, move.fromCol) ^
+                         pieceKey(move.wasPromotion ? move.promotedTo : move.movedPiece, move.toRow, move.toCol);
+        if (move.capturedPiece != ' ') {
+            delta ^= pieceKey(move.capturedPiece, move.toRow, move.toCol);
+        }
+        return delta;
+    }
+    
+    // Same for pawnKey: a pawn leaving, arriving (unless it promotes) or
+    // being captured
+    static uint64_t pawnKeyDelta(const MoveRecord& move) {
+        uint64_t delta = 0;
+        if (toupper(move.movedPiece) == 'P') {
+            delta ^= pieceKey(move.movedPiece, move.fromRow, move.fromCol);
+            if (!move.wasPromotion) {
+                delta ^= pieceKey(move.movedPiece, move.toRow, move.toCol);
+            }
+        }
+        if (toupper(move.capturedPiece) == 'P') {
+            delta ^= pieceKey(move.capturedPiece, move.toRow, move.toCol);
+        }
+        return delta;
+    }
+    
+    // Board change log for incremental rendering. Every board mutation bumps
+    // boardGeneration and stores the squares it touched in a small ring, so a
+    // renderer only has to patch the squares that changed since it last drew.
+    static const int CHANGE_LOG_SIZE = 64;
+    uint64_t changeLog[CHANGE_LOG_SIZE];
+    int boardGeneration;
+    
+    static uint64_t squareBit(int row, int col) {
+        return 1ULL << (row * SIZE + col);
+    }
+    
+    void recordChange(uint64_t touched) {
+        changeLog[boardGeneration % CHANGE_LOG_SIZE] = touched;
+        boardGeneration++;
+    }
+    
+    // Attack maps, kept in step with every move: attackCount[color][sq] is
+    // how many pieces of that color (0 white, 1 black) attack the square.
+    // A move recounts the pieces on its two squares in full, but for a
+    // slider elsewhere only the one ray that reaches either square.
+    uint8_t attackCount[2][SIZE * SIZE];
+    uint64_t occupied;      // Occupied squares, to find sliders quickly
+    int kingSquare[2];      // -1 when that king is missing
+    
+    // A slider ray passing over a changed square: piece square and direction
+    struct AttackRay {
+        int square;
+        int direction;
+    };
+    
+    struct AttackUpdate {
+        int squares[2];
+        AttackRay rays[16];
+        int rayCount;
+    };
+    
+    static int colorIndex(char piece) {
+        return islower(piece) ? 1 : 0;
+    }
+    
+    static const int (&rayDirections())[8][2] {
+        static const int directions[8][2] = {
+            {-1, 0}, {1, 0}, {0, -1}, {0, 1},
+            {-1, -1}, {-1, 1}, {1, -1}, {1, 1}
+        };
+        return directions;
+    }
+    
+    // Count (delta 1) or uncount (delta -1) one slider ray, up to and
+    // including the first piece on it
+    void addRayAttacks(int sq, int d, uint8_t* counts, int delta) {
+        const int dr = rayDirections()[d][0], dc = rayDirections()[d][1];
+        int r = sq / SIZE + dr;
+        int c = sq % SIZE + dc;
+        while (r >= 0 && r < SIZE && c >= 0 && c < SIZE) {
+            counts[r * SIZE + c] += delta;
+            if (board[r][c] != ' ') {
+                break;
+            }
+            r += dr;
+            c += dc;
+        }
+    }
+    
+    // Add (delta 1) or remove (delta -1) all attacks of the piece on sq
+    void addAttacks(int sq, int delta) {
+        static const int knightMoves[8][2] = {
+            {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
+            {1, -2}, {1, 2}, {2, -1}, {2, 1}
+        };
+        int row = sq / SIZE, col = sq % SIZE;
+        char piece = board[row][col];
+        if (piece == ' ') {
+            return;
+        }
+        uint8_t* counts = attackCount[colorIndex(piece)];
+        
+        switch (toupper(piece)) {
+        case 'P': {
+            int r = row + (isupper(piece) ? -1 : 1);
+            if (r >= 0 && r < SIZE) {
+                if (col > 0) counts[r * SIZE + col - 1] += delta;
+                if (col < SIZE - 1) counts[r * SIZE + col + 1] += delta;
+            }
+            break;
+        }
+        case 'N':
+        case 'K': {
+            const int (*steps)[2] = (toupper(piece) == 'N') ? knightMoves : rayDirections();
+            for (int k = 0; k < 8; k++) {
+                int r = row + steps[k][0];
+                int c = col + steps[k][1];
+                if (r >= 0 && r < SIZE && c >= 0 && c < SIZE) {
+                    counts[r * SIZE + c] += delta;
+                }
+            }
+            break;
+        }
+        case 'B':
+            for (int d = 4; d < 8; d++) addRayAttacks(sq, d, counts, delta);
+            break;
+        case 'R':
+            for (int d = 0; d < 4; d++) addRayAttacks(sq, d, counts, delta);
+            break;
+        default:
+            for (int d = 0; d < 8; d++) addRayAttacks(sq, d, counts, delta);
+            break;
+        }
+    }
+    
+    // Rebuild the attack maps and king squares from scratch
+    void computeAttacks() {
+        memset(attackCount, 0, sizeof(attackCount));
+        occupied = 0;
+        for (int sq = 0; sq < SIZE * SIZE; sq++) {
+            addAttacks(sq, 1);
+            occupied |= (uint64_t)(board[sq / SIZE][sq % SIZE] != ' ') << sq;
+        }
+        for (int color = 0; color < 2; color++) {
+            int row, col;
+            kingSquare[color] = findKing(color == 0 ? 'w' : 'b', row, col) ? row * SIZE + col : -1;
+        }
+    }
+    
+    // Squares along each ray from each square, nearest first being the
+    // lowest bit for directions that increase the index and the highest
+    // for those that decrease it
+    struct RayMasks {
+        uint64_t masks[SIZE * SIZE][8];
+        
+        RayMasks() {
+            for (int sq = 0; sq < SIZE * SIZE; sq++) {
+                for (int d = 0; d < 8; d++) {
+                    masks[sq][d] = 0;
+                    int r = sq / SIZE + rayDirections()[d][0];
+                    int c = sq % SIZE + rayDirections()[d][1];
+                    while (r >= 0 && r < SIZE && c >= 0 && c < SIZE) {
+                        masks[sq][d] |= 1ULL << (r * SIZE + c);
+                        r += rayDirections()[d][0];
+                        c += rayDirections()[d][1];
+                    }
+                }
+            }
+        }
+    };
+    
+    static const RayMasks& rayMasks() {
+        static const RayMasks table;
+        return table;
+    }
+    
+    // First half of an incremental update before squares a and b change:
+    // uncount the pieces on a and b, and the ray of every other slider that
+    // sees either square (looking through a and b, so rays that will open
+    // or close are included)
+    void beginAttackUpdate(int a, int b, AttackUpdate& update) {
+        update.squares[0] = a;
+        update.squares[1] = b;
+        update.rayCount = 0;
+        const RayMasks& rays = rayMasks();
+        uint64_t blockers = occupied & ~((1ULL << a) | (1ULL << b));
+        for (int origin : {a, b}) {
+            for (int d = 0; d < 8; d++) {
+                uint64_t hits = rays.masks[origin][d] & blockers;
+                if (!hits) {
+                    continue;
+                }
+                // Directions 1, 3, 6 and 7 increase the square index
+                int sq = (0xCA >> d & 1) ? __builtin_ctzll(hits) : 63 - __builtin_clzll(hits);
+                char piece = board[sq / SIZE][sq % SIZE];
+                char pieceType = toupper(piece);
+                if (pieceType == 'Q' || (pieceType == 'R' && d < 4) || (pieceType == 'B' && d >= 4)) {
+                    // The slider looks back along the opposite direction
+                    int back = (d < 4) ? (d ^ 1) : (11 - d);
+                    bool known = false;
+                    for (int i = 0; i < update.rayCount; i++) {
+                        known |= update.rays[i].square == sq && update.rays[i].direction == back;
+                    }
+                    if (!known) {
+                        update.rays[update.rayCount++] = {sq, back};
+                        addRayAttacks(sq, back, attackCount[colorIndex(piece)], -1);
+                    }
+                }
+            }
+        }
+        addAttacks(a, -1);
+        addAttacks(b, -1);
+    }
+    
+    // Second half: count the same rays and whatever now stands on a and b
+    void endAttackUpdate(const AttackUpdate& update) {
+        for (int i = 0; i < update.rayCount; i++) {
+            const AttackRay& ray = update.rays[i];
+            addRayAttacks(ray.square, ray.direction, attackCount[colorIndex(board[ray.square / SIZE][ray.square % SIZE])], 1);
+        }
+        for (int sq : update.squares) {
+            addAttacks(sq, 1);
+            occupied = (occupied & ~(1ULL << sq)) | ((uint64_t)(board[sq / SIZE][sq % SIZE] != ' ') << sq);
+        }
+    }
+    
+    // Follow the kings through a move played (forward) or taken back
+    void moveKings(const MoveRecord& move, bool forward) {
+        int from = move.fromRow * SIZE + move.fromCol, to = move.toRow * SIZE + move.toCol;
+        if (toupper(move.movedPiece) == 'K') {
+            kingSquare[colorIndex(move.movedPiece)] = forward ? to : from;
+        }
+        if (toupper(move.capturedPiece) == 'K') {
+            kingSquare[colorIndex(move.capturedPiece)] = forward ? -1 : to;
+        }
+    }
+    
+public:
+    // Occupied squares as a bitset (bit row * SIZE + col)
+    uint64_t getOccupancy() const {
+        uint64_t occupied = 0;
+        for (int sq = 0; sq < SIZE * SIZE; sq++) {
+            if (board[sq / SIZE][sq % SIZE] != ' ') occupied |= 1ULL << sq;
+        }
+        return occupied;
+    }
+    
+    // Pieces of both colors attacking a square, as a bitset. Only pieces
+    // still in occupied count, and sliders see through squares missing from
+    // it, so clearing a capturer's bit uncovers the attacker behind it.
+    uint64_t attackersTo(int row, int col, uint64_t occupied) const {
+        const int directions[8][2] = {
+            {-1, 0}, {1, 0}, {0, -1}, {0, 1},
+            {-1, -1}, {-1, 1}, {1, -1}, {1, 1}
+        };
+        const int knightMoves[8][2] = {
+            {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
+            {1, -2}, {1, 2}, {2, -1}, {2, 1}
+        };
+        uint64_t attackers = 0;
+        
+        for (int d = 0; d < 8; d++) {
+            int r = row + directions[d][0];
+            int c = col + directions[d][1];
+            while (r >= 0 && r < SIZE && c >= 0 && c < SIZE) {
+                if (occupied & squareBit(r, c)) {
+                    char pieceType = toupper(board[r][c]);
+                    if (pieceType == 'Q' || pieceType == (d < 4 ? 'R' : 'B')) {
+                        attackers |= squareBit(r, c);
+                    }
+                    break;
+                }
+                r += directions[d][0];
+                c += directions[d][1];
+            }
+        }
+        
+        for (int k = 0; k < 8; k++) {
+            int r = row + knightMoves[k][0], c = col + knightMoves[k][1];
+            if (r >= 0 && r < SIZE && c >= 0 && c < SIZE && toupper(board[r][c]) == 'N') {
+                attackers |= squareBit(r, c);
+            }
+            r = row + directions[k][0];
+            c = col + directions[k][1];
+            if (r >= 0 && r < SIZE && c >= 0 && c < SIZE && toupper(board[r][c]) == 'K') {
+                attackers |= squareBit(r, c);
+            }
+        }
+        
+        // White pawns attack from the row below, black pawns from above
+        for (int dc : {-1, 1}) {
+            int c = col + dc;
+            if (c < 0 || c >= SIZE) continue;
+            if (row + 1 < SIZE && board[row + 1][c] == 'P') attackers |= squareBit(row + 1, c);
+            if (row - 1 >= 0 && board[row - 1][c] == 'p') attackers |= squareBit(row - 1, c);
+        }
+        return attackers & occupied;
+    }
+    
+    // Piece values used by see(), in centipawns
+    static int seeValue(char piece) {
+        switch (toupper(piece)) {
+        case 'P': return 100;
+        case 'N': return 320;
+        case 'B': return 330;
+        case 'R': return 500;
+        case 'Q': return 900;
+        case 'K': return 20000;
+        default: return 0;
+        }
+    }
+    
+    // Static exchange evaluation: the material the side to move nets from
+    // move and the best sequence of recaptures on its target square, each
+    // side recapturing with its least valuable attacker and free to stop
+    // whenever continuing would lose more
+    int see(uint16_t move) const {
+        int from = move & 63, to = (move >> 6) & 63;
+        int toRow = to / SIZE, toCol = to % SIZE;
+        int gain[32];
+        int depth = 0;
+        
+        // A pawn reaching the last row arrives (and can be lost) as a queen
+        auto capturerValue = [&](int sq) {
+            char piece = board[sq / SIZE][sq % SIZE];
+            bool promotes = toupper(piece) == 'P' && (toRow == 0 || toRow == SIZE - 1);
+            return promotes ? seeValue('Q') : seeValue(piece);
+        };
+        auto promotionGain = [&](int sq) {
+            return capturerValue(sq) - seeValue(board[sq / SIZE][sq % SIZE]);
+        };
+        
+        uint64_t occupied = getOccupancy() ^ (1ULL << from);
+        bool whiteMoves = isupper(board[from / SIZE][from % SIZE]);
+        gain[0] = seeValue(board[toRow][toCol]) + promotionGain(from);
+        int onSquare = capturerValue(from);
+        
+        bool whiteToCapture = !whiteMoves;
+        while (depth < 31) {
+            uint64_t attackers = attackersTo(toRow, toCol, occupied);
+            
+            // Least valuable attacker of the side to capture
+            int next = -1, nextValue = 0;
+            for (uint64_t bits = attackers; bits; bits &= bits - 1) {
+                int sq = __builtin_ctzll(bits);
+                if ((bool)isupper(board[sq / SIZE][sq % SIZE]) != whiteToCapture) continue;
+                int value = seeValue(board[sq / SIZE][sq % SIZE]);
+                if (next < 0 || value < nextValue) {
+                    next = sq;
+                    nextValue = value;
+                }
+            }
+            if (next < 0) {
+                break;
+            }
+            
+            // A king can't capture onto a square the other side still covers
+            if (toupper(board[next / SIZE][next % SIZE]) == 'K') {
+                bool defended = false;
+                for (uint64_t bits = attackers & ~(1ULL << next); bits; bits &= bits - 1) {
+                    int sq = __builtin_ctzll(bits);
+                    defended |= (bool)isupper(board[sq / SIZE][sq % SIZE]) != whiteToCapture;
+                }
+                if (defended) break;
+            }
+            
+            depth++;
+            gain[depth] = onSquare + promotionGain(next) - gain[depth - 1];
+            onSquare = capturerValue(next);
+            occupied ^= 1ULL << next;
+            whiteToCapture = !whiteToCapture;
+        }
+        
+        while (depth > 0) {
+            gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+            depth--;
+        }
+        return gain[0];
+    }
+    
 private:
-    char board[SIZE][SIZE];
-    char currentPlayer;
-    bool inCheck;
+    // Get algebraic notation for a square (e.g., "e4")
+    std::string getSquareNotation(int row, int col) const {
+        std::string notation;
+        notation += ('a' + col);
+        notation += ('8' - row);
+        return notation;
+    }
+    
+    // Get piece notation for move history
+    std::string getPieceNotation(char piece) const {
+        char pieceType = toupper(piece);
+        if (pieceType == 'P') return "";
+        if (pieceType == 'N') return "N";
+        if (pieceType == 'B') return "B";
+        if (pieceType == 'R') return "R";
+        if (pieceType == 'Q') return "Q";
+        if (pieceType == 'K') return "K";
+        return "";
+    }
+
+    // Squares holding the given piece that can reach (row, col) in one
+    // move, found by walking the attack rays and offsets out from the target
+    uint64_t pieceAttackers(int row, int col, char piece) const {
+        const int directions[8][2] = {
+            {-1, 0}, {1, 0}, {0, -1}, {0, 1},
+            {-1, -1}, {-1, 1}, {1, -1}, {1, 1}
+        };
+        const int knightMoves[8][2] = {
+            {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
+            {1, -2}, {1, 2}, {2, -1}, {2, 1}
+        };
+        char pieceType = toupper(piece);
+        uint64_t attackers = 0;
+        
+        if (pieceType == 'N' || pieceType == 'K') {
+            for (int k = 0; k < 8; k++) {
+                int r = row + (pieceType == 'N' ? knightMoves[k][0] : directions[k][0]);
+                int c = col + (pieceType == 'N' ? knightMoves[k][1] : directions[k][1]);
+                if (r >= 0 && r < SIZE && c >= 0 && c < SIZE && board[r][c] == piece) {
+                    attackers |= squareBit(r, c);
+                }
+            }
+            return attackers;
+        }
+        
+        int firstDir = (pieceType == 'B') ? 4 : 0;
+        int lastDir = (pieceType == 'R') ? 4 : 8;
+        for (int d = firstDir; d < lastDir; d++) {
+            int r = row + directions[d][0];
+            int c = col + directions[d][1];
+            while (r >= 0 && r < SIZE && c >= 0 && c < SIZE) {
+                if (board[r][c] != ' ') {
+                    if (board[r][c] == piece) {
+                        attackers |= squareBit(r, c);
+                    }
+                    break;
+                }
+                r += directions[d][0];
+                c += directions[d][1];
+            }
+        }
+        return attackers;
+    }
+    
+    // Standard algebraic notation for a recorded move, computed against the
+    // board as it was before the move was played
+    std::string getMoveSAN(const MoveRecord& move) const {
+        std::string san;
+        char pieceType = toupper(move.movedPiece);
+        
+        if (pieceType == 'P') {
+            if (move.capturedPiece != ' ') {
+                san += (char)('a' + move.fromCol);
+                san += 'x';
+            }
+            san += getSquareNotation(move.toRow, move.toCol);
+            if (move.wasPromotion) {
+                san += '=';
+                san += (char)toupper(move.promotedTo);
+            }
+        } else {
+            san += pieceType;
+            
+            // Other pieces of the same kind that could also legally go there
+            uint64_t others = pieceAttackers(move.toRow, move.toCol, move.movedPiece) &
+                              ~squareBit(move.fromRow, move.fromCol);
+            char player = isupper(move.movedPiece) ? 'w' : 'b';
+            bool sameFile = false, sameRank = false, ambiguous = false;
+            for (int sq = 0; sq < SIZE * SIZE; sq++) {
+                if ((others & (1ULL << sq)) &&
+                    !wouldBeInCheck(sq / SIZE, sq % SIZE, move.toRow, move.toCol, player)) {
+                    ambiguous = true;
+                    if (sq % SIZE == move.fromCol) sameFile = true;
+                    if (sq / SIZE == move.fromRow) sameRank = true;
+                }
+            }
+            
+            if (ambiguous) {
+                if (!sameFile) {
+                    san += (char)('a' + move.fromCol);
+                } else if (!sameRank) {
+                    san += (char)('8' - move.fromRow);
+                } else {
+                    san += getSquareNotation(move.fromRow, move.fromCol);
+                }
+            }
+            
+            if (move.capturedPiece != ' ') {
+                san += 'x';
+            }
+            san += getSquareNotation(move.toRow, move.toCol);
+        }
+        
+        if (move.wasCheckmate) {
+            san += '#';
+        } else if (move.wasCheck) {
+            san += '+';
+        }
+        return san;
+    }
+    
+    // PGN string escaping for tag values
+    static std::string escapePGN(const std::string& value) {
+        std::string escaped;
+        for (char ch : value) {
+            if (ch == '"' || ch == '\\') {
+                escaped += '\\';
+            }
+            escaped += ch;
+        }
+        return escaped;
+    }
+
+    // Apply an already validated move to the board and history. The mate
+    // test is the expensive part, so trusted replays skip it per ply.
+    void applyMove(int fromR, int fromC, int toR, int toC, bool detectMate) {
+        // Move the pieces, promoting and switching player
+        AttackUpdate update;
+        beginAttackUpdate(fromR * SIZE + fromC, toR * SIZE + toC, update);
+        MoveRecord move = playOnBoard(fromR, fromC, toR, toC);
+        endAttackUpdate(update);
+        moveKings(move, true);
+        hashKey ^= moveKeyDelta(move);
+        pawnKey ^= pawnKeyDelta(move);
+        
+        // Check if the opponent is now in check or checkmate
+        inCheck = isInCheck(currentPlayer);
+        move.wasCheck = inCheck;
+        move.wasCheckmate = detectMate && isCheckmate();
+        
+        // Add the move to history
+        recordMove(move);
+        recordChange(move.touchedSquares);
+    }
+    
+    // Men on the board (kings included) in square order; returns their
+    // count, or -1 when there are more than limit
+    int collectMen(char* pieces, int* squares, int limit) const {
+        int count = 0;
+        for (int sq = 0; sq < SIZE * SIZE; sq++) {
+            char piece = board[sq / SIZE][sq % SIZE];
+            if (piece == ' ') continue;
+            if (count == limit) return -1;
+            pieces[count] = piece;
+            squares[count++] = sq;
+        }
+        return count;
+    }
+    
+    // Bitbase verdict (see probeBitbase) for men from collectMen
+    int bitbaseVerdict(const char* men, const int* menSquares, int menCount) const {
+        int whiteKing = -1, blackKing = -1, pieceCount = 0;
+        int squares[2];
+        char pieces[2];
+        
+        for (int i = 0; i < menCount; i++) {
+            if (men[i] == 'K') {
+                whiteKing = menSquares[i];
+            } else if (men[i] == 'k') {
+                blackKing = menSquares[i];
+            } else {
+                if (pieceCount == 2) return BITBASE_UNKNOWN;
+                squares[pieceCount] = menSquares[i];
+                pieces[pieceCount++] = men[i];
+            }
+        }
+        if (whiteKing < 0 || blackKing < 0) {
+            return BITBASE_UNKNOWN;
+        }
+        if (pieceCount == 0) {
+            return 0;
+        }
+        
+        // Normalize so the side with material is White
+        bool strongIsWhite = isupper(pieces[0]);
+        if (pieceCount == 2 && (bool)isupper(pieces[1]) != strongIsWhite) {
+            return BITBASE_UNKNOWN;
+        }
+        bool whiteToMove = (currentPlayer == 'w');
+        if (!strongIsWhite) {
+            int king = whiteKing;
+            whiteKing = blackKing ^ 56;
+            blackKing = king ^ 56;
+            for (int i = 0; i < pieceCount; i++) squares[i] ^= 56;
+            whiteToMove = !whiteToMove;
+        }
+        
+        int table;
+        char first = toupper(pieces[0]);
+        if (pieceCount == 1) {
+            table = (first == 'P') ? BB_KPK : (first == 'R') ? BB_KRK : (first == 'Q') ? BB_KQK : -1;
+        } else {
+            char second = toupper(pieces[1]);
+            table = ((first == 'B' && second == 'N') || (first == 'N' && second == 'B')) ? BB_KBNK : -1;
+            if (first == 'N') std::swap(squares[0], squares[1]);
+        }
+        if (table < 0 || !chessBitbases().has(table)) {
+            return BITBASE_UNKNOWN;
+        }
+        
+        bool whiteWins = chessBitbases().whiteWins(table, Bitbases::index(table, whiteToMove, whiteKing, blackKing, squares));
+        if (!whiteWins) {
+            return 0;
+        }
+        return whiteToMove ? 1 : -1;
+    }
+
+public:
+    ChessGame() {
+        boardGeneration = 0;
+        initialize();
+    }
+
+    void initialize() {
+        Core::initialize();
+        baseHalfmoveClock = 0;
+        baseMoveNumber = 1;
+        computeAttacks();
+        inCheck = false;
+        hashKey = computeHash();
+        pawnKey = computePawnHash();
+        
+        // Every square may have changed
+        recordChange(~0ULL);
+    }
+
+    // Set up a position from FEN. Castling and en passant fields are accepted
+    // but ignored, as the engine plays neither; the move counters are kept
+    // for getFEN. Clears the move history.
+    bool loadFEN(const std::string& fen) {
+        char newBoard[SIZE][SIZE];
+        size_t i = 0;
+        int row = 0, col = 0;
+        
+        for (; i < fen.size() && fen[i] != ' '; i++) {
+            char ch = fen[i];
+            if (ch == '/') {
+                if (col != SIZE) return false;
+                row++;
+                col = 0;
+            } else if (ch >= '1' && ch <= '8') {
+                for (int k = 0; k < ch - '0'; k++) {
+                    if (col >= SIZE || row >= SIZE) return false;
+                    newBoard[row][col++] = ' ';
+                }
+            } else if (strchr("KQRBNPkqrbnp", ch)) {
+                if (col >= SIZE || row >= SIZE) return false;
+                newBoard[row][col++] = ch;
+            } else {
+                return false;
+            }
+        }
+        if (row != SIZE - 1 || col != SIZE) {
+            return false;
+        }
+        
+        char player = 'w';
+        if (i + 1 < fen.size()) {
+            if (fen[i + 1] == 'b') {
+                player = 'b';
+            } else if (fen[i + 1] != 'w') {
+                return false;
+            }
+        }
+        
+        if (!setBoardState(std::string(&newBoard[0][0], SIZE * SIZE), player)) {
+            return false;
+        }
+        
+        // Optional halfmove clock and fullmove number after castling and
+        // en passant
+        int halfmoves = 0, moveNumber = 1;
+        sscanf(fen.c_str() + i, " %*s %*s %*s %d %d", &halfmoves, &moveNumber);
+        baseHalfmoveClock = std::max(0, halfmoves);
+        baseMoveNumber = std::max(1, moveNumber);
+        return true;
+    }
+    
+    // Inverse of getBoardState: set all 64 squares (rank 8 first) and the
+    // player to move. Clears the move history.
+    bool setBoardState(const std::string& state, char player) {
+        if (state.size() != SIZE * SIZE || (player != 'w' && player != 'b')) {
+            return false;
+        }
+        for (char ch : state) {
+            if (ch != ' ' && !isPieceChar(ch)) {
+                return false;
+            }
+        }
+        
+        memcpy(board, state.data(), sizeof(board));
+        currentPlayer = player;
+        moveHistory.clear();
+        currentMoveIndex = -1;
+        baseHalfmoveClock = 0;
+        baseMoveNumber = 1;
+        computeAttacks();
+        inCheck = isInCheck(currentPlayer);
+        hashKey = computeHash();
+        pawnKey = computePawnHash();
+        recordChange(~0ULL);
+        return true;
+    }
+    
+    // One of "KQRBNPkqrbnp" (strchr alone would also accept '\0')
+    static bool isPieceChar(char ch) {
+        return ch != '\0' && strchr("KQRBNPkqrbnp", ch) != nullptr;
+    }
+    
+    // Snapshot of the whole session (position, history and redo tail) in
+    // the GameSnapshotHeader layout, replacing the contents of buffer
+    void serialize(std::vector<uint8_t>& buffer) const {
+        GameSnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "CGSS", 4);
+        header.version = GAME_SNAPSHOT_VERSION;
+        header.currentMoveIndex = currentMoveIndex;
+        header.moveCount = (uint32_t)moveHistory.size();
+        header.baseHalfmoveClock = (uint32_t)baseHalfmoveClock;
+        header.baseMoveNumber = (uint32_t)baseMoveNumber;
+        memcpy(header.board, board, sizeof(board));
+        header.currentPlayer = currentPlayer;
+        
+        buffer.resize(sizeof(header) + moveHistory.size() * sizeof(GameSnapshotMove));
+        memcpy(buffer.data(), &header, sizeof(header));
+        uint8_t* out = buffer.data() + sizeof(header);
+        for (const MoveRecord& record : moveHistory) {
+            GameSnapshotMove move;
+            move.move = encodeMove(record.fromRow, record.fromCol, record.toRow, record.toCol);
+            move.movedPiece = record.movedPiece;
+            move.capturedPiece = record.capturedPiece;
+            move.promotedTo = record.promotedTo;
+            move.flags = (record.wasCheck ? 1 : 0) | (record.wasCheckmate ? 2 : 0);
+            memcpy(out, &move, sizeof(move));
+            out += sizeof(move);
+        }
+    }
+    
+    // Restore a session written by serialize. The records are checked,
+    // then copied back in one pass; only the attack maps and hash keys are
+    // recomputed from the board. On failure (wrong magic or version,
+    // truncated data, or pieces and squares that don't fit) the game is
+    // unchanged.
+    bool deserialize(const uint8_t* data, size_t size) {
+        GameSnapshotHeader header;
+        if (size < sizeof(header)) {
+            return false;
+        }
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.magic, "CGSS", 4) != 0 || header.version != GAME_SNAPSHOT_VERSION ||
+            size != sizeof(header) + (uint64_t)header.moveCount * sizeof(GameSnapshotMove) ||
+            header.currentMoveIndex < -1 || header.currentMoveIndex >= (int64_t)header.moveCount ||
+            (header.currentPlayer != 'w' && header.currentPlayer != 'b') ||
+            header.baseHalfmoveClock > INT32_MAX || header.baseMoveNumber < 1 || header.baseMoveNumber > INT32_MAX) {
+            return false;
+        }
+        for (char ch : header.board) {
+            if (ch != ' ' && !isPieceChar(ch)) {
+                return false;
+            }
+        }
+        
+        // Check every record before touching the game, so that undo and
+        // redo only ever see real pieces. The mover's color alternates back
+        // from the side to move, and the moves either side of the current
+        // position must fit the board.
+        const uint8_t* records = data + sizeof(header);
+        for (uint32_t i = 0; i < header.moveCount; i++) {
+            GameSnapshotMove move;
+            memcpy(&move, records + i * sizeof(move), sizeof(move));
+            int from = move.move & 63, to = (move.move >> 6) & 63;
+            bool whiteMoves = (((header.currentMoveIndex - (int64_t)i) & 1) != 0) == (header.currentPlayer == 'w');
+            char queen = whiteMoves ? 'Q' : 'q';
+            if ((move.move >> 12) != 0 || from == to || !isPieceChar(move.movedPiece) ||
+                (bool)isupper(move.movedPiece) != whiteMoves ||
+                (move.capturedPiece != ' ' &&
+                 (!isPieceChar(move.capturedPiece) || (bool)isupper(move.capturedPiece) == whiteMoves)) ||
+                (move.promotedTo != ' ' && (move.promotedTo != queen || toupper(move.movedPiece) != 'P')) ||
+                (move.flags & ~3) != 0) {
+                return false;
+            }
+            const char* fromSquare = &header.board[from];
+            const char* toSquare = &header.board[to];
+            if ((int64_t)i == header.currentMoveIndex &&
+                (*fromSquare != ' ' || *toSquare != (move.promotedTo != ' ' ? move.promotedTo : move.movedPiece))) {
+                return false;
+            }
+            if ((int64_t)i == header.currentMoveIndex + 1 &&
+                (*fromSquare != move.movedPiece || *toSquare != move.capturedPiece)) {
+                return false;
+            }
+        }
+        
+        // Allocate first, so running out of memory leaves the game unchanged
+        moveHistory.reserve(header.moveCount);
+        memcpy(board, header.board, sizeof(board));
+        currentPlayer = header.currentPlayer;
+        currentMoveIndex = header.currentMoveIndex;
+        baseHalfmoveClock = (int)header.baseHalfmoveClock;
+        baseMoveNumber = (int)header.baseMoveNumber;
+        moveHistory.resize(header.moveCount);
+        const uint8_t* in = records;
+        for (MoveRecord& record : moveHistory) {
+            GameSnapshotMove move;
+            memcpy(&move, in, sizeof(move));
+            in += sizeof(move);
+            int from = move.move & 63, to = (move.move >> 6) & 63;
+            record.fromRow = from / SIZE;
+            record.fromCol = from % SIZE;
+            record.toRow = to / SIZE;
+            record.toCol = to % SIZE;
+            record.movedPiece = move.movedPiece;
+            record.capturedPiece = move.capturedPiece;
+            record.wasCheck = move.flags & 1;
+            record.wasCheckmate = move.flags & 2;
+            record.wasPromotion = move.promotedTo != ' ';
+            record.promotedTo = move.promotedTo;
+            record.touchedSquares = (1ULL << from) | (1ULL << to);
+        }
+        computeAttacks();
+        inCheck = isInCheck(currentPlayer);
+        hashKey = computeHash();
+        pawnKey = computePawnHash();
+        recordChange(~0ULL);
+        return true;
+    }
+    
+    bool deserialize(const std::vector<uint8_t>& buffer) {
+        return deserialize(buffer.data(), buffer.size());
+    }
+    
+    // Current position as FEN
+    std::string getFEN() const {
+        std::string fen;
+        for (int r = 0; r < SIZE; r++) {
+            int empty = 0;
+            for (int c = 0; c < SIZE; c++) {
+                if (board[r][c] == ' ') {
+                    empty++;
+                    continue;
+                }
+                if (empty > 0) {
+                    fen += (char)('0' + empty);
+                    empty = 0;
+                }
+                fen += board[r][c];
+            }
+            if (empty > 0) {
+                fen += (char)('0' + empty);
+            }
+            if (r < SIZE - 1) {
+                fen += '/';
+            }
+        }
+        fen += (currentPlayer == 'w') ? " w - - " : " b - - ";
+        
+        // Plies since the last capture or pawn move, and one more move
+        // number for every Black move since the start
+        int plies = currentMoveIndex + 1;
+        int64_t halfmoves = (int64_t)baseHalfmoveClock + plies;
+        for (int i = currentMoveIndex; i >= 0; i--) {
+            if (moveHistory[i].capturedPiece != ' ' || toupper(moveHistory[i].movedPiece) == 'P') {
+                halfmoves = currentMoveIndex - i;
+                break;
+            }
+        }
+        bool whiteStarted = (plies % 2 == 0) == (currentPlayer == 'w');
+        fen += std::to_string(halfmoves) + " " + std::to_string((int64_t)baseMoveNumber + (plies + !whiteStarted) / 2);
+        return fen;
+    }
+    
+    // Generation of the current board; pass it to getChangedSquares later
+    int getGeneration() const {
+        return boardGeneration;
+    }
+    
+    // Mask of squares (bit = row * SIZE + col) changed since the given
+    // generation. Generations older than the change log report every square.
+    uint64_t getChangedMask(int sinceGeneration) const {
+        if (sinceGeneration >= boardGeneration) {
+            return 0;
+        }
+        if (sinceGeneration < 0 || boardGeneration - sinceGeneration > CHANGE_LOG_SIZE) {
+            return ~0ULL;
+        }
+        
+        uint64_t mask = 0;
+        for (int g = sinceGeneration; g < boardGeneration; g++) {
+            mask |= changeLog[g % CHANGE_LOG_SIZE];
+        }
+        return mask;
+    }
+    
+    // Squares changed since the given generation as "<index><piece>" entries
+    // separated by commas, e.g. "36P,52 " after 1. e2-e4
+    std::string getChangedSquares(int sinceGeneration) const {
+        uint64_t mask = getChangedMask(sinceGeneration);
+        std::string changes;
+        for (int sq = 0; sq < SIZE * SIZE; sq++) {
+            if (mask & (1ULL << sq)) {
+                if (!changes.empty()) {
+                    changes += ",";
+                }
+                changes += std::to_string(sq);
+                changes += board[sq / SIZE][sq % SIZE];
+            }
+        }
+        return changes;
+    }
+    
+    bool isInCheckState() const {
+        return inCheck;
+    }
+    
+    // Whether the player's king is attacked, from the attack maps. The
+    // core's isSquareUnderAttack scan remains for boards changed in place.
+    bool isInCheck(char player) const {
+        int us = (player == 'w') ? 0 : 1;
+        return kingSquare[us] >= 0 && attackCount[us ^ 1][kingSquare[us]] > 0;
+    }
+    
+    // Whether any piece of attackingPlayer attacks the square
+    bool isSquareAttacked(int row, int col, char attackingPlayer) const {
+        return attackCount[attackingPlayer == 'w' ? 0 : 1][row * SIZE + col] > 0;
+    }
+    
+    // How many pieces of attackingPlayer attack the square
+    int getAttackerCount(int row, int col, char attackingPlayer) const {
+        return attackCount[attackingPlayer == 'w' ? 0 : 1][row * SIZE + col];
+    }
+    
+    // Squares attacked by a player (bit = row * SIZE + col)
+    uint64_t getAttackMap(char attackingPlayer) const {
+        const uint8_t* counts = attackCount[attackingPlayer == 'w' ? 0 : 1];
+        uint64_t map = 0;
+        for (int sq = 0; sq < SIZE * SIZE; sq++) {
+            map |= (uint64_t)(counts[sq] != 0) << sq;
+        }
+        return map;
+    }
+    
+    // Attack overlay for the UI: one character per square, rank 8 first,
+    // '0'-'9' for the number of the player's attackers (capped at 9)
+    std::string getAttackOverlay(char attackingPlayer) const {
+        const uint8_t* counts = attackCount[attackingPlayer == 'w' ? 0 : 1];
+        std::string overlay(SIZE * SIZE, '0');
+        for (int sq = 0; sq < SIZE * SIZE; sq++) {
+            overlay[sq] = (char)('0' + std::min<int>(counts[sq], 9));
+        }
+        return overlay;
+    }
+    
+    // Whether a pseudo-legal move of the side to move keeps its king out of
+    // check, answered from the attack maps where possible. A king move is
+    // safe when its target is unattacked and no enemy slider stands behind
+    // the king on the line it moves along. Out of check, any other move is
+    // safe unless the piece is pinned and leaves the pin line. Moves made
+    // while in check are tried on the board.
+    bool keepsKingSafe(int fromR, int fromC, int toR, int toC) const {
+        int us = (currentPlayer == 'w') ? 0 : 1;
+        int king = kingSquare[us];
+        if (king < 0) {
+            return true;
+        }
+        int from = fromR * SIZE + fromC, to = toR * SIZE + toC;
+        
+        // Enemy slider on square sq able to attack along direction d
+        auto isEnemySlider = [&](int sq, int d) {
+            char piece = board[sq / SIZE][sq % SIZE];
+            char pieceType = toupper(piece);
+            return colorIndex(piece) != us &&
+                   (pieceType == 'Q' || pieceType == (d < 4 ? 'R' : 'B'));
+        };
+        // Nearest occupied square along direction d from sq, or -1
+        const RayMasks& rays = rayMasks();
+        auto firstBlocker = [&](int sq, int d, uint64_t blockers) {
+            uint64_t hits = rays.masks[sq][d] & blockers;
+            if (!hits) return -1;
+            return (0xCA >> d & 1) ? __builtin_ctzll(hits) : 63 - __builtin_clzll(hits);
+        };
+        
+        if (from == king) {
+            if (attackCount[us ^ 1][to]) {
+                return false;
+            }
+            // Direction from the target back through the king
+            for (int d = 0; d < 8; d++) {
+                if (rays.masks[to][d] & (1ULL << from)) {
+                    int behind = firstBlocker(from, d, occupied);
+                    return behind < 0 || !isEnemySlider(behind, d);
+                }
+            }
+            return true;
+        }
+        
+        if (inCheck) {
+            return !wouldBeInCheck(fromR, fromC, toR, toC, currentPlayer);
+        }
+        
+        // Out of check only a pin matters: the piece must be the first one
+        // on a line from the king, with an enemy slider next behind it
+        for (int d = 0; d < 8; d++) {
+            if (rays.masks[king][d] & (1ULL << from)) {
+                if (firstBlocker(king, d, occupied) != from) {
+                    return true;
+                }
+                int pinner = firstBlocker(from, d, occupied);
+                if (pinner < 0 || !isEnemySlider(pinner, d)) {
+                    return true;
+                }
+                // Pinned: it may only move along the line, up to the pinner
+                return (rays.masks[king][d] & ~rays.masks[pinner][d] & (1ULL << to)) != 0;
+            }
+        }
+        return true;
+    }
+    
+    bool isCheckmate() const {
+        return inCheck && !hasLegalMoves(currentPlayer);
+    }
+    
+    bool isStalemate() const {
+        return !inCheck && !hasLegalMoves(currentPlayer);
+    }
+
+    bool makeMove(int fromR, int fromC, int toR, int toC) {
+        CHESS_STAT_ADD(STAT_MAKE_MOVE, 1);
+        CHESS_STAT_TIMER(STAT_MAKE_MOVE_NS);
+        CHESS_TRACE_SCOPE("makeMove");
+        
+        // Check if the move is valid according to chess rules
+        if (!moveCheck(fromR, fromC, toR, toC, currentPlayer)) {
+            return false;
+        }
+        
+        // Check if the move would leave the king in check
+        if (!keepsKingSafe(fromR, fromC, toR, toC)) {
+            return false;
+        }
+        
+        applyMove(fromR, fromC, toR, toC, true);
+        return true;
+    }
+    
+    bool undoMove() {
+        if (!canUndo()) {
+            return false;
+        }
+        
+        // Get the last move
+        const MoveRecord& move = moveHistory[currentMoveIndex];
+        
+        // Restore the board state and the previous player
+        AttackUpdate update;
+        beginAttackUpdate(move.fromRow * SIZE + move.fromCol, move.toRow * SIZE + move.toCol, update);
+        takeBackOnBoard(move);
+        endAttackUpdate(update);
+        moveKings(move, false);
+        hashKey ^= moveKeyDelta(move);
+        pawnKey ^= pawnKeyDelta(move);
+        
+        // Update check status (the starting position may be a FEN in check)
+        inCheck = (currentMoveIndex > 0) ? moveHistory[currentMoveIndex - 1].wasCheck : isInCheck(currentPlayer);
+        
+        // Update the current move index
+        currentMoveIndex--;
+        recordChange(move.touchedSquares);
+        
+        return true;
+    }
+    
+    bool redoMove() {
+        if (!canRedo()) {
+            return false;
+        }
+        
+        // Get the next move
+        const MoveRecord& move = moveHistory[currentMoveIndex + 1];
+        
+        // Apply the move and switch player
+        AttackUpdate update;
+        beginAttackUpdate(move.fromRow * SIZE + move.fromCol, move.toRow * SIZE + move.toCol, update);
+        replayOnBoard(move);
+        endAttackUpdate(update);
+        moveKings(move, true);
+        hashKey ^= moveKeyDelta(move);
+        pawnKey ^= pawnKeyDelta(move);
+        
+        // Update check status
+        inCheck = move.wasCheck;
+        
+        // Update the current move index
+        currentMoveIndex++;
+        recordChange(move.touchedSquares);
+        
+        return true;
+    }
+
+    bool isGameOver() const {
+        // Game is over if there's a checkmate or stalemate
+        return isCheckmate() || isStalemate() || !hasKings();
+    }
+    
+    std::string getMoveHistory() const {
+        std::string history;
+        for (size_t i = 0; i < moveHistory.size(); i++) {
+            const MoveRecord& move = moveHistory[i];
+            
+            // Add move number for white's moves
+            if (i % 2 == 0) {
+                history += std::to_string(i / 2 + 1) + ". ";
+            }
+            
+            // Add piece notation (except for pawns)
+            history += getPieceNotation(move.movedPiece);
+            
+            // Add source and destination squares
+            history += getSquareNotation(move.fromRow, move.fromCol);
+            
+            // Use 'x' for captures
+            if (move.capturedPiece != ' ') {
+                history += "x";
+            } else {
+                history += "-";
+            }
+            
+            history += getSquareNotation(move.toRow, move.toCol);
+            
+            // Add promotion indicator
+            if (move.wasPromotion) {
+                history += "=" + std::string(1, toupper(move.promotedTo));
+            }
+            
+            // Add check/checkmate indicator
+            if (move.wasCheckmate) {
+                history += "#";
+            } else if (move.wasCheck) {
+                history += "+";
+            }
+            
+            // Add separator
+            if (i < moveHistory.size() - 1) {
+                if (i % 2 == 0) {
+                    history += " ";  // Space between white and black moves
+                } else {
+                    history += ", ";  // Comma between move pairs
+                }
+            }
+        }
+        return history;
+    }
+    
+    // Stream the game up to the current move as PGN. The Seven Tag Roster is
+    // always written, with extra or overriding tags taken from headers; a
+    // Result tag only counts while the final position decides nothing.
+    // Games that don't start from the initial position add SetUp and FEN. SAN
+    // movetext is produced ply by ply on a scratch board and written straight
+    // to the sink, wrapped at 80 columns.
+    void writePGN(std::ostream& out,
+                  const std::vector<std::pair<std::string, std::string>>& headers =
+                      std::vector<std::pair<std::string, std::string>>()) const {
+        // Game result from the final position
+        std::string result = "*";
+        std::string status = getGameStatus();
+        if (status == "checkmate_white") {
+            result = "1-0";
+        } else if (status == "checkmate_black") {
+            result = "0-1";
+        } else if (status == "stalemate") {
+            result = "1/2-1/2";
+        }
+        
+        // Rewind a scratch board to the start of the game
+        ChessGame scratch;
+        memcpy(scratch.board, board, sizeof(board));
+        scratch.currentPlayer = currentPlayer;
+        for (int i = currentMoveIndex; i >= 0; i--) {
+            const MoveRecord& move = moveHistory[i];
+            scratch.board[move.fromRow][move.fromCol] = move.movedPiece;
+            scratch.board[move.toRow][move.toCol] = move.capturedPiece;
+            scratch.currentPlayer = (scratch.currentPlayer == 'w') ? 'b' : 'w';
+        }
+        scratch.baseHalfmoveClock = baseHalfmoveClock;
+        scratch.baseMoveNumber = baseMoveNumber;
+        
+        const char* rosterTags[7] = {"Event", "Site", "Date", "Round", "White", "Black", "Result"};
+        std::string rosterValues[7] = {"?", "?", "????.??.??", "?", "?", "?", result};
+        std::vector<bool> used(headers.size(), false);
+        for (int t = 0; t < 7; t++) {
+            for (size_t h = 0; h < headers.size(); h++) {
+                if (headers[h].first == rosterTags[t]) {
+                    if (t != 6 || result == "*") {
+                        rosterValues[t] = headers[h].second;
+                    }
+                    used[h] = true;
+                }
+            }
+            out << '[' << rosterTags[t] << " \"" << escapePGN(rosterValues[t]) << "\"]\n";
+        }
+        
+        // Games that didn't start from the initial position carry their setup
+        std::string startFEN = scratch.getFEN();
+        if (startFEN != ChessGame().getFEN()) {
+            out << "[SetUp \"1\"]\n[FEN \"" << startFEN << "\"]\n";
+        }
+        for (size_t h = 0; h < headers.size(); h++) {
+            if (!used[h]) {
+                out << '[' << headers[h].first << " \"" << escapePGN(headers[h].second) << "\"]\n";
+            }
+        }
+        out << '\n';
+        
+        int column = 0;
+        auto writeToken = [&out, &column](const std::string& token) {
+            if (column > 0 && column + 1 + (int)token.size() > 79) {
+                out << '\n';
+                column = 0;
+            } else if (column > 0) {
+                out << ' ';
+                column++;
+            }
+            out << token;
+            column += (int)token.size();
+        };
+        
+        int plyOffset = (scratch.currentPlayer == 'w') ? 0 : 1;
+        for (int i = 0; i <= currentMoveIndex; i++) {
+            const MoveRecord& move = moveHistory[i];
+            int moveNumber = baseMoveNumber + (i + plyOffset) / 2;
+            
+            if (scratch.currentPlayer == 'w') {
+                writeToken(std::to_string(moveNumber) + ".");
+            } else if (i == 0) {
+                writeToken(std::to_string(moveNumber) + "...");
+            }
+            writeToken(scratch.getMoveSAN(move));
+            
+            scratch.board[move.toRow][move.toCol] = move.wasPromotion ? move.promotedTo : move.movedPiece;
+            scratch.board[move.fromRow][move.fromCol] = ' ';
+            scratch.currentPlayer = (scratch.currentPlayer == 'w') ? 'b' : 'w';
+        }
+        writeToken(rosterValues[6]);
+        out << "\n\n";
+    }
+    
+    // Generate all legal moves for the current player as packed moves (see
+    // encodeMove). moves must hold MAX_MOVES entries; returns the count.
+    // A target square (row * SIZE + col) limits generation to moves landing
+    // there, skipping the check test for everything else.
+    int generateLegalMoves(uint16_t* moves, int onlyTo = -1) const {
+        return generateMoves(moves, GEN_ALL | GEN_LEGAL, onlyTo);
+    }
     
-    // Store move history for undo/redo functionality
-    struct MoveRecord {
-        int fromRow;
-        int fromCol;
-        int toRow;
-        int toCol;
-        char movedPiece;
-        char capturedPiece;
-        bool wasCheck;
-        bool wasCheckmate;
-        bool wasPromotion;
-        char promotedTo;
+    // Move kinds for generateMoves. Without GEN_LEGAL the moves are only
+    // pseudo-legal: they may leave the king in check (see isLegal).
+    enum MoveGenFlags {
+        GEN_CAPTURES = 1,   // Captures and promotions
+        GEN_QUIETS = 2,     // Everything else
+        GEN_ALL = 3,
+        GEN_LEGAL = 4
     };
     
-    std::vector<MoveRecord> moveHistory;
-    int currentMoveIndex; // Current position in move history
+    bool isCaptureOrPromotion(uint16_t move) const {
+        int from = move & 63, to = (move >> 6) & 63;
+        return board[to / SIZE][to % SIZE] != ' ' ||
+               (toupper(board[from / SIZE][from % SIZE]) == 'P' && (to / SIZE == 0 || to / SIZE == SIZE - 1));
+    }
+    
+    // Whether a pseudo-legal move keeps the mover's king out of check
+    bool isLegal(uint16_t move) const {
+        int from = move & 63, to = (move >> 6) & 63;
+        return keepsKingSafe(from / SIZE, from % SIZE, to / SIZE, to % SIZE);
+    }
+    
+    // Whether a move from elsewhere (a killer, say) is pseudo-legal here
+    bool isPseudoLegal(uint16_t move) const {
+        int from = move & 63, to = (move >> 6) & 63;
+        return from != to && moveCheck(from / SIZE, from % SIZE, to / SIZE, to % SIZE, currentPlayer);
+    }
+    
+    int generateMoves(uint16_t* moves, int flags, int onlyTo = -1) const {
+        const int directions[8][2] = {
+            {-1, 0}, {1, 0}, {0, -1}, {0, 1},
+            {-1, -1}, {-1, 1}, {1, -1}, {1, 1}
+        };
+        const int knightMoves[8][2] = {
+            {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
+            {1, -2}, {1, 2}, {2, -1}, {2, 1}
+        };
+        char player = currentPlayer;
+        int count = 0;
+        
+        // Keep a candidate only if it is of a requested kind and, for legal
+        // generation, doesn't leave our king in check
+        auto tryAdd = [&](int fromR, int fromC, int toR, int toC) {
+            bool capture = board[toR][toC] != ' ' || (toupper(board[fromR][fromC]) == 'P' && (toR == 0 || toR == SIZE - 1));
+            if ((flags & (capture ? GEN_CAPTURES : GEN_QUIETS)) &&
+                (onlyTo < 0 || onlyTo == toR * SIZE + toC) &&
+                (!(flags & GEN_LEGAL) || keepsKingSafe(fromR, fromC, toR, toC))) {
+                moves[count++] = encodeMove(fromR, fromC, toR, toC);
+            }
+        };
+        
+        for (int fromR = 0; fromR < SIZE; fromR++) {
+            for (int fromC = 0; fromC < SIZE; fromC++) {
+                char piece = board[fromR][fromC];
+                if (piece == ' ' || (player == 'w' && islower(piece)) || (player == 'b' && isupper(piece))) {
+                    continue;
+                }
+                char pieceType = toupper(piece);
+                
+                if (pieceType == 'P') {
+                    int direction = (player == 'w') ? -1 : 1;
+                    int r = fromR + direction;
+                    if (r < 0 || r >= SIZE) {
+                        continue;
+                    }
+                    
+                    // Pushes, including the double step from the starting row
+                    if (board[r][fromC] == ' ') {
+                        tryAdd(fromR, fromC, r, fromC);
+                        int startRow = (player == 'w') ? 6 : 1;
+                        if (fromR == startRow && board[r + direction][fromC] == ' ') {
+                            tryAdd(fromR, fromC, r + direction, fromC);
+                        }
+                    }
+                    
+                    // Diagonal captures
+                    for (int dc : {-1, 1}) {
+                        int c = fromC + dc;
+                        if (c >= 0 && c < SIZE && board[r][c] != ' ' && !isSameColorPiece(r, c, player)) {
+                            tryAdd(fromR, fromC, r, c);
+                        }
+                    }
+                } else if (pieceType == 'N' || pieceType == 'K') {
+                    for (int k = 0; k < 8; k++) {
+                        int r = fromR + (pieceType == 'N' ? knightMoves[k][0] : directions[k][0]);
+                        int c = fromC + (pieceType == 'N' ? knightMoves[k][1] : directions[k][1]);
+                        if (r >= 0 && r < SIZE && c >= 0 && c < SIZE && !isSameColorPiece(r, c, player)) {
+                            tryAdd(fromR, fromC, r, c);
+                        }
+                    }
+                } else {
+                    // Sliding pieces walk each ray until blocked
+                    int firstDir = (pieceType == 'B') ? 4 : 0;
+                    int lastDir = (pieceType == 'R') ? 4 : 8;
+                    for (int d = firstDir; d < lastDir; d++) {
+                        int r = fromR + directions[d][0];
+                        int c = fromC + directions[d][1];
+                        while (r >= 0 && r < SIZE && c >= 0 && c < SIZE) {
+                            if (isSameColorPiece(r, c, player)) {
+                                break;
+                            }
+                            tryAdd(fromR, fromC, r, c);
+                            if (board[r][c] != ' ') {
+                                break;
+                            }
+                            r += directions[d][0];
+                            c += directions[d][1];
+                        }
+                    }
+                }
+            }
+        }
+        
+        return count;
+    }
     
-    // Helper function to check if path is clear for sliding pieces
-    bool isPathClear(int fromR, int fromC, int toR, int toC) const {
-        int rowStep = (toR > fromR) ? 1 : ((toR < fromR) ? -1 : 0);
-        int colStep = (toC > fromC) ? 1 : ((toC < fromC) ? -1 : 0);
+    // Resolve a move in SAN ("Nbd7", "exd5", "e8=Q+") or coordinate form
+    // ("e2e4") against the legal moves of the current position. Fails on
+    // unknown, illegal or ambiguous moves, castling and underpromotion,
+    // none of which this engine plays.
+    bool parseSAN(const char* san, size_t len, uint16_t& move) const {
+        // Strip check, mate and annotation suffixes
+        while (len > 0 && (san[len - 1] == '+' || san[len - 1] == '#' ||
+                           san[len - 1] == '!' || san[len - 1] == '?')) {
+            len--;
+        }
+        if (len < 2) {
+            return false;
+        }
         
-        int r = fromR + rowStep;
-        int c = fromC + colStep;
+        uint16_t legal[MAX_MOVES];
+        int legalCount;
         
-        while (r != toR || c != toC) {
-            if (board[r][c] != ' ') {
+        // Coordinate form, as accepted by the command-line game
+        if (len >= 4 && len <= 5 &&
+            san[0] >= 'a' && san[0] <= 'h' && san[1] >= '1' && san[1] <= '8' &&
+            san[2] >= 'a' && san[2] <= 'h' && san[3] >= '1' && san[3] <= '8' &&
+            (len == 4 || san[4] == 'q' || san[4] == 'Q')) {
+            uint16_t candidate = encodeMove('8' - san[1], san[0] - 'a', '8' - san[3], san[2] - 'a');
+            legalCount = generateLegalMoves(legal, candidate >> 6);
+            for (int i = 0; i < legalCount; i++) {
+                if (legal[i] == candidate) {
+                    move = candidate;
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        char pieceType = 'P';
+        size_t i = 0;
+        if (san[0] == 'N' || san[0] == 'B' || san[0] == 'R' || san[0] == 'Q' || san[0] == 'K') {
+            pieceType = san[0];
+            i = 1;
+        }
+        
+        // Promotion suffix, "=Q" or a bare "Q"
+        char promotion = ' ';
+        if (len >= 4 && san[len - 2] == '=') {
+            promotion = san[len - 1];
+            len -= 2;
+        } else if (pieceType == 'P' && len >= 3 && isupper(san[len - 1])) {
+            promotion = san[len - 1];
+            len -= 1;
+        }
+        if (promotion != ' ' && promotion != 'Q') {
+            return false;
+        }
+        if (len < i + 2) {
+            return false;
+        }
+        
+        int toC = san[len - 2] - 'a';
+        int toR = '8' - san[len - 1];
+        if (toC < 0 || toC >= SIZE || toR < 0 || toR >= SIZE) {
+            return false;
+        }
+        
+        // Optional disambiguation and capture marker
+        int fromC = -1, fromR = -1;
+        for (size_t k = i; k < len - 2; k++) {
+            if (san[k] >= 'a' && san[k] <= 'h') {
+                fromC = san[k] - 'a';
+            } else if (san[k] >= '1' && san[k] <= '8') {
+                fromR = '8' - san[k];
+            } else if (san[k] != 'x' && san[k] != '-') {
                 return false;
             }
-            r += rowStep;
-            c += colStep;
         }
         
-        return true;
+        legalCount = generateLegalMoves(legal, toR * SIZE + toC);
+        int matches = 0;
+        for (int m = 0; m < legalCount; m++) {
+            int from = legal[m] & 63;
+            int to = (legal[m] >> 6) & 63;
+            if (to != toR * SIZE + toC ||
+                toupper(board[from / SIZE][from % SIZE]) != pieceType ||
+                (fromC >= 0 && from % SIZE != fromC) ||
+                (fromR >= 0 && from / SIZE != fromR)) {
+                continue;
+            }
+            move = legal[m];
+            matches++;
+        }
+        
+        return matches == 1;
     }
     
-    // Check if destination square has a piece of the same color
-    bool isSameColorPiece(int r, int c, char player) const {
-        if (board[r][c] == ' ') return false;
-        
-        if (player == 'w') {
-            return isupper(board[r][c]);
-        } else {
-            return islower(board[r][c]);
+    // Zobrist hash of the current position
+    uint64_t getHashKey() const {
+        return hashKey;
+    }
+    
+    // Zobrist hash of the pawns only, maintained like getHashKey
+    uint64_t getPawnKey() const {
+        return pawnKey;
+    }
+    
+    // Packed move in UCI coordinate form ("e2e4", "e7e8q"), for the current
+    // position (the promotion suffix depends on the piece moved)
+    std::string moveToUCI(uint16_t move) const {
+        int from = move & 63, to = (move >> 6) & 63;
+        std::string text = getSquareNotation(from / SIZE, from % SIZE) + getSquareNotation(to / SIZE, to % SIZE);
+        char piece = board[from / SIZE][from % SIZE];
+        if ((piece == 'P' && to / SIZE == 0) || (piece == 'p' && to / SIZE == SIZE - 1)) {
+            text += 'q';
+        }
+        return text;
+    }
+    
+    // Pack a move into 16 bits: from square in bits 0-5, to square in
+    // bits 6-11 (square = row * SIZE + col)
+    static uint16_t encodeMove(int fromR, int fromC, int toR, int toC) {
+        return (uint16_t)((fromR * SIZE + fromC) | ((toR * SIZE + toC) << 6));
+    }
+    
+    // Make room in the history for moves more moves after the current one,
+    // so that playing them can't run out of memory part-way. Throws
+    // std::bad_alloc with the game unchanged.
+    void reserveHistory(size_t moves) {
+        size_t needed = currentMoveIndex + 1 + moves;
+        if (moveHistory.capacity() < needed) {
+            moveHistory.reserve(std::max(needed, 2 * moveHistory.capacity()));
         }
     }
     
-    // Find the position of the king for a given player
-    bool findKing(char player, int& kingRow, int& kingCol) const {
-        char kingChar = (player == 'w') ? 'K' : 'k';
+    // Replay moves that were validated when they were first played (e.g.
+    // restored from our own database). Moves are applied without rule or
+    // check legality tests; debug builds still assert them. Release builds
+    // only make sure each move takes one of the mover's pieces to a square
+    // not holding a king or another of its own, so corrupt input can't
+    // corrupt memory. Returns false at the first move that fails this;
+    // earlier moves stay applied.
+    bool replayTrusted(const uint16_t* moves, size_t n) {
+        moveHistory.reserve(currentMoveIndex + 1 + n);
         
-        for (int r = 0; r < SIZE; r++) {
-            for (int c = 0; c < SIZE; c++) {
-                if (board[r][c] == kingChar) {
-                    kingRow = r;
-                    kingCol = c;
-                    return true;
-                }
+        for (size_t i = 0; i < n; i++) {
+            int from = moves[i] & 63;
+            int to = (moves[i] >> 6) & 63;
+            int fromR = from / SIZE, fromC = from % SIZE;
+            int toR = to / SIZE, toC = to % SIZE;
+            
+            char piece = board[fromR][fromC];
+            char target = board[toR][toC];
+            if ((moves[i] >> 12) != 0 || piece == ' ' || colorIndex(piece) != (currentPlayer == 'w' ? 0 : 1) ||
+                (target != ' ' && (colorIndex(target) == colorIndex(piece) || toupper(target) == 'K'))) {
+                return false;
             }
+            assert(moveCheck(fromR, fromC, toR, toC, currentPlayer));
+            assert(!wouldBeInCheck(fromR, fromC, toR, toC, currentPlayer));
+            
+            applyMove(fromR, fromC, toR, toC, false);
         }
         
-        return false; // King not found (shouldn't happen in a valid game)
+        // Only the final move of a valid game can deliver mate
+        if (n > 0 && inCheck) {
+            moveHistory[currentMoveIndex].wasCheckmate = isCheckmate();
+        }
+        return true;
     }
     
-    // Check if a square is under attack by the opponent
-    bool isSquareUnderAttack(int row, int col, char attackingPlayer) const {
-        // Check attacks from all 8 directions (for queen, rook, bishop)
-        const int directions[8][2] = {
-            {-1, 0}, {1, 0}, {0, -1}, {0, 1},  // Rook/Queen directions
-            {-1, -1}, {-1, 1}, {1, -1}, {1, 1}  // Bishop/Queen directions
-        };
+    // Same as above for the getRawMoveHistory format ("e2e4,e7e5,...").
+    // Returns false at the first malformed move; earlier moves stay applied.
+    bool replayTrusted(const std::string& rawHistory) {
+        std::vector<uint16_t> moves;
+        moves.reserve(rawHistory.size() / 5 + 1);
         
-        // Check sliding pieces (queen, rook, bishop)
-        for (int d = 0; d < 8; d++) {
-            int dr = directions[d][0];
-            int dc = directions[d][1];
-            int r = row + dr;
-            int c = col + dc;
+        size_t i = 0;
+        bool ok = true;
+        while (i + 4 <= rawHistory.size()) {
+            int fromC = rawHistory[i] - 'a';
+            int fromR = '8' - rawHistory[i + 1];
+            int toC = rawHistory[i + 2] - 'a';
+            int toR = '8' - rawHistory[i + 3];
             
-            while (r >= 0 && r < SIZE && c >= 0 && c < SIZE) {
-                if (board[r][c] != ' ') {
-                    char piece = board[r][c];
-                    bool isPieceFromAttackingPlayer = (attackingPlayer == 'w') ? isupper(piece) : islower(piece);
-                    
-                    if (isPieceFromAttackingPlayer) {
-                        char pieceType = toupper(piece);
-                        
-                        // Check if this piece can attack in this direction
-                        if (pieceType == 'Q' || 
-                            (pieceType == 'R' && d < 4) ||  // Rook can only attack in first 4 directions
-                            (pieceType == 'B' && d >= 4)) {  // Bishop can only attack in last 4 directions
-                            return true;
-                        }
-                    }
-                    
-                    // Blocked by a piece, stop checking this direction
-                    break;
-                }
-                
-                r += dr;
-                c += dc;
+            if (fromR < 0 || fromR >= SIZE || fromC < 0 || fromC >= SIZE ||
+                toR < 0 || toR >= SIZE || toC < 0 || toC >= SIZE) {
+                ok = false;
+                break;
+            }
+            moves.push_back(encodeMove(fromR, fromC, toR, toC));
+            
+            i += 4;
+            if (i < rawHistory.size() && rawHistory[i] == ',') {
+                i++;
             }
         }
+        if (i != rawHistory.size()) {
+            ok = false;
+        }
         
-        // Check knight attacks
-        const int knightMoves[8][2] = {
-            {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
-            {1, -2}, {1, 2}, {2, -1}, {2, 1}
-        };
-        
-        for (int k = 0; k < 8; k++) {
-            int r = row + knightMoves[k][0];
-            int c = col + knightMoves[k][1];
-            
-            if (r >= 0 && r < SIZE && c >= 0 && c < SIZE) {
-                char piece = board[r][c];
-                bool isPieceFromAttackingPlayer = (attackingPlayer == 'w') ? isupper(piece) : islower(piece);
-                
-                if (isPieceFromAttackingPlayer && toupper(piece) == 'N') {
-                    return true;
+        return replayTrusted(moves.data(), moves.size()) && ok;
+    }
+    
+    // Hot-path counters summed over all threads, as a JSON object. Reports
+    // {"enabled":false} unless built with CHESS_STATS.
+    static std::string getStats() {
+#ifdef CHESS_STATS
+        uint64_t totals[STAT_COUNT];
+        ChessStatsRegistry& registry = chessStatsRegistry();
+        {
+            std::lock_guard<std::mutex> guard(registry.lock);
+            for (int i = 0; i < STAT_COUNT; i++) {
+                totals[i] = registry.retired[i];
+            }
+            for (ChessStatsBlock* block : registry.blocks) {
+                for (int i = 0; i < STAT_COUNT; i++) {
+                    totals[i] += block->counters[i].load(std::memory_order_relaxed);
                 }
             }
         }
         
-        // Check pawn attacks
-        int pawnDirection = (attackingPlayer == 'w') ? -1 : 1;  // White pawns attack downward, black pawns attack upward
-        char pawnChar = (attackingPlayer == 'w') ? 'P' : 'p';
-        
-        for (int dc : {-1, 1}) {  // Pawns attack diagonally
-            int r = row + pawnDirection;
-            int c = col + dc;
-            
-            if (r >= 0 && r < SIZE && c >= 0 && c < SIZE && board[r][c] == pawnChar) {
-                return true;
+        std::string json = "{\"enabled\":true";
+        for (int i = 0; i < STAT_COUNT; i++) {
+            json += ",\"";
+            json += chessStatNames[i];
+            json += "\":" + std::to_string(totals[i]);
+        }
+        return json + "}";
+#else
+        return "{\"enabled\":false}";
+#endif
+    }
+    
+    // Zero all counters. Increments racing with the reset may survive it.
+    static void resetStats() {
+#ifdef CHESS_STATS
+        ChessStatsRegistry& registry = chessStatsRegistry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        for (int i = 0; i < STAT_COUNT; i++) {
+            registry.retired[i] = 0;
+        }
+        for (ChessStatsBlock* block : registry.blocks) {
+            for (int i = 0; i < STAT_COUNT; i++) {
+                block->counters[i].store(0, std::memory_order_relaxed);
             }
         }
+#endif
+    }
+    
+    // Every thread's recorded spans as Chrome trace event JSON. Reports an
+    // empty trace unless built with CHESS_TRACE.
+    static std::string getTrace() {
+        std::string json = "{\"traceEvents\":[";
+#ifdef CHESS_TRACE
+        ChessTraceRegistry& registry = chessTraceRegistry();
+        std::vector<ChessTraceBuffer*> buffers;
+        {
+            std::lock_guard<std::mutex> guard(registry.lock);
+            buffers = registry.buffers;
+        }
         
-        // Check king attacks (for adjacent squares)
-        const int kingMoves[8][2] = {
-            {-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
-            {0, 1}, {1, -1}, {1, 0}, {1, 1}
-        };
-        
-        char kingChar = (attackingPlayer == 'w') ? 'K' : 'k';
-        
-        for (int k = 0; k < 8; k++) {
-            int r = row + kingMoves[k][0];
-            int c = col + kingMoves[k][1];
-            
-            if (r >= 0 && r < SIZE && c >= 0 && c < SIZE && board[r][c] == kingChar) {
-                return true;
+        bool first = true;
+        char text[160];
+        for (ChessTraceBuffer* buffer : buffers) {
+            uint64_t end = buffer->head.load(std::memory_order_acquire);
+            uint64_t begin = (end > CHESS_TRACE_CAPACITY) ? end - CHESS_TRACE_CAPACITY : 0;
+            for (uint64_t i = begin; i < end; i++) {
+                // Spans the owner overwrites while we copy are dropped
+                ChessTraceEvent event;
+                if (!buffer->read(i, event)) {
+                    continue;
+                }
+                int length = snprintf(text, sizeof(text), "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                                      first ? "" : ",", event.name, buffer->tid, event.startNs / 1000.0, event.durationNs / 1000.0);
+                json.append(text, length);
+                if (event.arg != TRACE_NO_ARG) {
+                    json += ",\"args\":{\"value\":" + std::to_string(event.arg) + "}";
+                }
+                json += '}';
+                first = false;
             }
         }
-        
-        return false;
+#endif
+        return json + "],\"displayTimeUnit\":\"ns\"}";
     }
     
-    // Check if the current player is in check
-    bool isInCheck(char player) const {
-        int kingRow, kingCol;
-        if (!findKing(player, kingRow, kingCol)) {
-            return false;  // King not found (shouldn't happen in a valid game)
+    // Discard all recorded spans. Spans recorded during the reset may survive it.
+    static void resetTrace() {
+#ifdef CHESS_TRACE
+        ChessTraceRegistry& registry = chessTraceRegistry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        for (ChessTraceBuffer* buffer : registry.buffers) {
+            buffer->head.store(0, std::memory_order_release);
         }
-        
-        char opponentPlayer = (player == 'w') ? 'b' : 'w';
-        return isSquareUnderAttack(kingRow, kingCol, opponentPlayer);
+#endif
     }
     
-    // Check if a move would leave the player's king in check
-    bool wouldBeInCheck(int fromR, int fromC, int toR, int toC, char player) const {
-        // Make a temporary copy of the board
-        char tempBoard[SIZE][SIZE];
-        for (int r = 0; r < SIZE; r++) {
-            for (int c = 0; c < SIZE; c++) {
-                tempBoard[r][c] = board[r][c];
+    int getCurrentMoveIndex() const {
+        return currentMoveIndex;
+    }
+    
+    // Load evaluation weights (see chess_tune) for every search. Load before
+    // searching; searchers that already ran keep stale pawn hash entries
+    // until cleared.
+    static bool loadEvalWeights(const std::string& path) {
+        return chessEvalWeights().load(path.c_str());
+    }
+    
+    // Load win/draw bitbases (see chess_bitbase_gen) for every game
+    static bool loadBitbases(const std::string& path) {
+        return chessBitbases().load(path.c_str());
+    }
+    
+    // Exact verdict for the side to move from the bitbases: 1 win, 0 draw,
+    // -1 loss, or BITBASE_UNKNOWN when no table covers the position. Bare
+    // kings are always a draw.
+    static const int BITBASE_UNKNOWN = -2;
+    
+    int probeBitbase() const {
+        char pieces[TB_MAX_PIECES];
+        int squares[TB_MAX_PIECES];
+        return bitbaseVerdict(pieces, squares, collectMen(pieces, squares, 4));
+    }
+    
+    // Map every *.ctb tablebase in a directory (see chess_tb_gen) for every
+    // game; returns how many tables were added
+    static int loadTablebases(const std::string& directory) {
+        return chessTablebases().loadDirectory(directory.c_str());
+    }
+    
+    // Tablebase verdict for the side to move: 1 win, 0 draw, -1 loss, or
+    // TABLEBASE_UNKNOWN when no loaded table covers the position
+    static const int TABLEBASE_UNKNOWN = -1000;
+    
+    int probeWDL() const {
+        return entryWDL(probeTablebase());
+    }
+    
+    // Plies until the winning side converts (captures, promotes or mates):
+    // positive when the side to move wins, negative when it loses, 0 for a
+    // draw (and for a side already checkmated). Capped at 127.
+    int probeDTZ() const {
+        return entryDTZ(probeTablebase());
+    }
+    
+    // Raw tablebase entry for the position (see Tablebases), or -1 when no
+    // loaded table covers it
+    int probeTablebase() const {
+        const Tablebases& tablebases = chessTablebases();
+        char pieces[TB_MAX_PIECES];
+        int squares[TB_MAX_PIECES];
+        int count = collectMen(pieces, squares, tablebases.maxMen);
+        return count < 0 ? -1 : tablebases.probe(pieces, squares, count, currentPlayer == 'w');
+    }
+    
+    // probeWDL / probeDTZ of a raw entry
+    static int entryWDL(int entry) {
+        if (entry < 0) {
+            return TABLEBASE_UNKNOWN;
+        }
+        return entry == 0 ? 0 : (entry < 128 ? 1 : -1);
+    }
+    
+    static int entryDTZ(int entry) {
+        if (entry < 0) {
+            return TABLEBASE_UNKNOWN;
+        }
+        return entry < 128 ? entry : -(entry - 128);
+    }
+    
+    // Both endgame probes from a single board scan, for the search: returns
+    // the probeBitbase verdict and, when no bitbase covers the position,
+    // sets entry to the probeTablebase entry (-1 otherwise)
+    int probeEndgame(int& entry) const {
+        const Tablebases& tablebases = chessTablebases();
+        char pieces[TB_MAX_PIECES];
+        int squares[TB_MAX_PIECES];
+        int count = collectMen(pieces, squares, std::max(4, tablebases.maxMen));
+        int verdict = bitbaseVerdict(pieces, squares, count);
+        entry = -1;
+        if (verdict == BITBASE_UNKNOWN && count >= 0 && count <= tablebases.maxMen) {
+            entry = tablebases.probe(pieces, squares, count, currentPlayer == 'w');
+        }
+        return verdict;
+    }
+    
+    // Map an opening book (see chess_book_build) for every game
+    static bool loadBook(const std::string& path) {
+        return chessOpeningBook().open(path.c_str());
+    }
+    
+    // Book moves for the current position, most played first; moves and
+    // weights must hold MAX_MOVES entries. Entries that aren't legal here (a
+    // hash collision) are left out. Returns the count.
+    int getBookMoves(uint16_t* moves, uint16_t* weights) const {
+        const OpeningBook& book = chessOpeningBook();
+        int found = 0;
+        for (uint64_t i = book.lowerBound(hashKey); i < book.count && book.entries[i].key == hashKey; i++) {
+            uint16_t move = book.entries[i].move;
+            int from = move & 63, to = (move >> 6) & 63;
+            if (found < MAX_MOVES && moveCheck(from / SIZE, from % SIZE, to / SIZE, to % SIZE, currentPlayer) &&
+                !wouldBeInCheck(from / SIZE, from % SIZE, to / SIZE, to % SIZE, currentPlayer)) {
+                moves[found] = move;
+                weights[found++] = book.entries[i].weight;
             }
         }
-        
-        // Temporarily make the move on the copy
-        ChessGame* nonConstThis = const_cast<ChessGame*>(this);
-        char originalPiece = nonConstThis->board[fromR][fromC];
-        char capturedPiece = nonConstThis->board[toR][toC];
-        
-        nonConstThis->board[toR][toC] = nonConstThis->board[fromR][fromC];
-        nonConstThis->board[fromR][fromC] = ' ';
-        
-        // Check if the king is in check after the move
-        bool inCheck = isInCheck(player);
-        
-        // Restore the original board
-        nonConstThis->board[fromR][fromC] = originalPiece;
-        nonConstThis->board[toR][toC] = capturedPiece;
-        
-        return inCheck;
+        return found;
     }
     
-    // Check if the current player has any legal moves
-    bool hasLegalMoves(char player) const {
-        for (int fromR = 0; fromR < SIZE; fromR++) {
-            for (int fromC = 0; fromC < SIZE; fromC++) {
-                char piece = board[fromR][fromC];
-                
-                // Skip empty squares and opponent's pieces
-                if (piece == ' ' || (player == 'w' && islower(piece)) || (player == 'b' && isupper(piece))) {
+    // A book move chosen by weight using random (any 32-bit value), or 0
+    // when the position isn't in the book
+    uint16_t pickBookMove(uint32_t random) const {
+        uint16_t moves[MAX_MOVES], weights[MAX_MOVES];
+        int count = getBookMoves(moves, weights);
+        uint32_t total = 0;
+        for (int i = 0; i < count; i++) total += weights[i];
+        if (total == 0) {
+            return 0;
+        }
+        uint32_t pick = random % total;
+        for (int i = 0; i < count; i++) {
+            if (pick < weights[i]) return moves[i];
+            pick -= weights[i];
+        }
+        return 0;
+    }
+    
+    // Same in coordinate notation ("e2e4"), or "" when out of book
+    std::string getBookMove(uint32_t random) const {
+        uint16_t move = pickBookMove(random);
+        return move ? moveToUCI(move) : "";
+    }
+    
+    std::string getGameStatus() const {
+        CHESS_TRACE_SCOPE("getGameStatus");
+        if (isCheckmate()) {
+            return std::string("checkmate_") + (currentPlayer == 'w' ? "black" : "white");
+        } else if (isStalemate()) {
+            return "stalemate";
+        } else if (inCheck) {
+            return std::string("check_") + (currentPlayer == 'w' ? "white" : "black");
+        } else {
+            return "ongoing";
+        }
+    }
+};
+
+// Static evaluation terms, all from White's view. Each takes the weights to
+// score with and, for tuning, an optional features array (EW_COUNT entries)
+// that receives how often each weight was used: +1 per use for White, -1
+// for Black. The score is always the dot product of the two.
+struct Evaluation {
+    // Index of a piece's type in the material and piece-square weights
+    static int pieceType(char piece) {
+        switch (toupper(piece)) {
+        case 'P': return 0;
+        case 'N': return 1;
+        case 'B': return 2;
+        case 'R': return 3;
+        case 'Q': return 4;
+        default: return 5;
+        }
+    }
+    
+    // Material and piece-square tables; kings receives both king squares
+    static int pieceTerms(const ChessGame& pos, const EvalWeights& weights, int kings[2], int* features) {
+        int score = 0;
+        kings[0] = kings[1] = 0;
+        for (int r = 0; r < SIZE; r++) {
+            for (int c = 0; c < SIZE; c++) {
+                char piece = pos.board[r][c];
+                if (piece == ' ') {
                     continue;
                 }
+                bool white = isupper(piece);
+                int type = pieceType(piece);
+                if (type == 5) {
+                    kings[!white] = r * SIZE + c;
+                }
                 
-                // Try all possible destination squares
-                for (int toR = 0; toR < SIZE; toR++) {
-                    for (int toC = 0; toC < SIZE; toC++) {
-                        // Check if the move is valid and doesn't leave the king in check
-                        if (moveCheck(fromR, fromC, toR, toC, player) && 
-                            !wouldBeInCheck(fromR, fromC, toR, toC, player)) {
-                            return true;
-                        }
+                // Black reads the tables mirrored top to bottom
+                int sq = white ? r * SIZE + c : (SIZE - 1 - r) * SIZE + c;
+                int material = EW_MATERIAL + type, square = EW_PST + type * 64 + sq;
+                int value = weights.values[material] + weights.values[square];
+                score += white ? value : -value;
+                if (features) {
+                    features[material] += white ? 1 : -1;
+                    features[square] += white ? 1 : -1;
+                }
+            }
+        }
+        return score;
+    }
+    
+    // Pawns of one side as a bitboard (bit = row * SIZE + col)
+    static uint64_t pawnBits(const ChessGame& pos, char pawn) {
+        uint64_t bits = 0;
+        for (int sq = 0; sq < SIZE * SIZE; sq++) {
+            if (pos.board[sq / SIZE][sq % SIZE] == pawn) {
+                bits |= 1ULL << sq;
+            }
+        }
+        return bits;
+    }
+    
+    // Passed, isolated and doubled pawn terms of one side's pawns, own,
+    // against the other side's; white tells which way own pawns advance.
+    // Returned from own's view.
+    static int pawnStructure(uint64_t own, uint64_t enemy, bool white, const EvalWeights& weights, int* features) {
+        int sign = white ? 1 : -1;
+        int score = 0;
+        for (int file = 0; file < SIZE; file++) {
+            int count = 0;
+            bool neighbours = false;
+            for (int row = 0; row < SIZE; row++) {
+                count += (own >> (row * SIZE + file)) & 1;
+                for (int side = file - 1; side <= file + 1; side += 2) {
+                    if (side >= 0 && side < SIZE && ((own >> (row * SIZE + side)) & 1)) {
+                        neighbours = true;
                     }
                 }
             }
+            int doubled = std::max(0, count - 1), isolated = neighbours ? 0 : count;
+            score += doubled * weights.values[EW_DOUBLED_PAWN] + isolated * weights.values[EW_ISOLATED_PAWN];
+            if (features) {
+                features[EW_DOUBLED_PAWN] += sign * doubled;
+                features[EW_ISOLATED_PAWN] += sign * isolated;
+            }
         }
         
-        return false;
+        for (uint64_t bits = own; bits; bits &= bits - 1) {
+            int sq = __builtin_ctzll(bits);
+            int row = sq / SIZE, file = sq % SIZE;
+            bool passed = true;
+            for (int r = white ? row - 1 : row + 1; passed && r >= 0 && r < SIZE; r += white ? -1 : 1) {
+                for (int f = std::max(0, file - 1); f <= std::min(SIZE - 1, file + 1); f++) {
+                    if ((enemy >> (r * SIZE + f)) & 1) {
+                        passed = false;
+                    }
+                }
+            }
+            if (passed) {
+                int weight = EW_PASSED_PAWN + (white ? SIZE - 1 - row : row);
+                score += weights.values[weight];
+                if (features) features[weight] += sign;
+            }
+        }
+        return score;
     }
     
-    // Get algebraic notation for a square (e.g., "e4")
-    std::string getSquareNotation(int row, int col) const {
-        std::string notation;
-        notation += ('a' + col);
-        notation += ('8' - row);
-        return notation;
+    // Own pawns in front of a king on its first two ranks, from own's view
+    static int pawnShield(uint64_t own, int king, bool white, const EvalWeights& weights, int* features) {
+        int row = king / SIZE, file = king % SIZE;
+        if (white ? row < SIZE - 2 : row > 1) {
+            return 0;
+        }
+        int step = white ? -SIZE : SIZE, score = 0;
+        for (int f = std::max(0, file - 1); f <= std::min(SIZE - 1, file + 1); f++) {
+            int sq = row * SIZE + f;
+            int weight = ((own >> (sq + step)) & 1) ? EW_SHIELD_NEAR
+                         : ((own >> (sq + 2 * step)) & 1) ? EW_SHIELD_FAR : EW_SHIELD_MISSING;
+            score += weights.values[weight];
+            if (features) features[weight] += white ? 1 : -1;
+        }
+        return score;
     }
     
-    // Get piece notation for move history
-    std::string getPieceNotation(char piece) const {
-        char pieceType = toupper(piece);
-        if (pieceType == 'P') return "";
-        if (pieceType == 'N') return "N";
-        if (pieceType == 'B') return "B";
-        if (pieceType == 'R') return "R";
-        if (pieceType == 'Q') return "Q";
-        if (pieceType == 'K') return "K";
-        return "";
+    // The whole evaluation from White's view, as the search computes it
+    // without its pawn hash table
+    static int evaluate(const ChessGame& pos, const EvalWeights& weights, int* features) {
+        int kings[2];
+        int score = pieceTerms(pos, weights, kings, features);
+        uint64_t white = pawnBits(pos, 'P'), black = pawnBits(pos, 'p');
+        score += pawnStructure(white, black, true, weights, features) - pawnStructure(black, white, false, weights, features);
+        score += pawnShield(white, kings[0], true, weights, features) - pawnShield(black, kings[1], false, weights, features);
+        return score;
     }
+};
 
-public:
-    ChessGame() {
-        initialize();
-        currentPlayer = 'w'; // White starts
-        currentMoveIndex = -1; // No moves made yet
-        inCheck = false;
-    }
+// Limits for one search. Zero leaves a limit unset; with none set the
+// search runs until stopped.
+struct SearchLimits {
+    int depth = 0;
+    uint64_t nodes = 0;
+    int movetime = 0;              // Milliseconds for this move
+    int wtime = 0, btime = 0;      // Clock times in milliseconds
+    int winc = 0, binc = 0;
+    int movestogo = 0;
+    bool infinite = false;
+    bool ponder = false;           // Search the opponent's time until ponderhit
+};
 
-    void initialize() {
-        // Initialize black pieces (lowercase)
-        board[0][0] = board[0][7] = 'r';
-        board[0][1] = board[0][6] = 'n';
-        board[0][2] = board[0][5] = 'b';
-        board[0][3] = 'q';
-        board[0][4] = 'k';
-        for (int i = 0; i < SIZE; i++) {
-            board[1][i] = 'p';
-        }
+// Result of one completed iteration
+struct SearchInfo {
+    int depth;
+    int score;                     // Centipawns for the side to move, or a mate score
+    uint64_t nodes;
+    int64_t timeMs;
+    std::vector<uint16_t> pv;
+};
+
+// One candidate line of a multi-PV analysis
+struct AnalysisLine {
+    int score;                     // As in SearchInfo
+    std::vector<uint16_t> pv;
+};
 
-        // Initialize white pieces (uppercase)
-        board[7][0] = board[7][7] = 'R';
-        board[7][1] = board[7][6] = 'N';
-        board[7][2] = board[7][5] = 'B';
-        board[7][3] = 'Q';
-        board[7][4] = 'K';
-        for (int i = 0; i < SIZE; i++) {
-            board[6][i] = 'P';
+// Result of a multi-PV analysis at its deepest completed depth; lines are
+// best first
+struct AnalysisResult {
+    int depth = 0;
+    uint64_t nodes = 0;
+    int64_t timeMs = 0;
+    std::vector<AnalysisLine> lines;
+    
+    // {"depth":12,"nodes":...,"timeMs":...,"lines":[{"cp":35,"pv":["e2e4",...]},
+    // {"mate":-3,"pv":[...]}]}, with moves in coordinate notation
+    std::string toJSON(const ChessGame& position) const;
+};
+
+// Move ordering statistics from one thread's search: two killers per ply
+// (quiet moves that caused a cutoff there), the quiet move that last refuted
+// each previous move, and history scores per side and from/to squares
+struct MoveHistory {
+    static const int MAX_PLY = 128;
+    static const int HISTORY_MAX = 16384;
+    
+    uint16_t killers[MAX_PLY][2];
+    uint16_t counterMoves[SIZE * SIZE][SIZE * SIZE];
+    int history[2][SIZE * SIZE][SIZE * SIZE];
+    
+    MoveHistory() {
+        clear();
+    }
+    
+    void clear() {
+        memset(killers, 0, sizeof(killers));
+        memset(counterMoves, 0, sizeof(counterMoves));
+        memset(history, 0, sizeof(history));
+    }
+    
+    int score(char player, uint16_t move) const {
+        return history[player == 'w' ? 0 : 1][move & 63][(move >> 6) & 63];
+    }
+    
+    uint16_t counterMove(uint16_t previous) const {
+        return previous ? counterMoves[previous & 63][(previous >> 6) & 63] : 0;
+    }
+    
+    // A quiet move caused a cutoff: reward it, penalize the quiet moves
+    // tried before it, and remember it as killer and countermove. Scores
+    // decay toward zero as they grow, so they stay within HISTORY_MAX.
+    void update(char player, int ply, uint16_t previous, uint16_t best,
+                const uint16_t* tried, int triedCount, int depth) {
+        int bonus = std::min(depth * depth, 400);
+        adjust(player, best, bonus);
+        for (int i = 0; i < triedCount; i++) {
+            adjust(player, tried[i], -bonus);
+        }
+        if (killers[ply][0] != best) {
+            killers[ply][1] = killers[ply][0];
+            killers[ply][0] = best;
         }
+        if (previous) {
+            counterMoves[previous & 63][(previous >> 6) & 63] = best;
+        }
+    }
+    
+    void adjust(char player, uint16_t move, int bonus) {
+        int& entry = history[player == 'w' ? 0 : 1][move & 63][(move >> 6) & 63];
+        entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+    }
+};
 
-        // Initialize empty spaces
-        for (int i = 2; i < 6; i++) {
-            for (int j = 0; j < SIZE; j++) {
-                board[i][j] = ' ';
+// Hands out the legal moves of a position one at a time, best first, in
+// stages: the hash move, captures that don't lose material (by SEE, most
+// valuable victim first), the two killers, the countermove, the remaining
+// quiet moves by history and finally the losing captures. Each stage is
+// generated only when reached, so a cutoff on an early move never pays for
+// the rest; within a stage the next move is a single selection pass, never a
+// full sort. Legality is checked only for moves actually handed out. In
+// captures-only mode (quiescence) only the good captures are produced.
+class MovePicker {
+private:
+    enum Stage {
+        STAGE_HASH,
+        STAGE_INIT_CAPTURES,
+        STAGE_GOOD_CAPTURES,
+        STAGE_KILLER_1,
+        STAGE_KILLER_2,
+        STAGE_COUNTER,
+        STAGE_INIT_QUIETS,
+        STAGE_QUIETS,
+        STAGE_BAD_CAPTURES,
+        STAGE_DONE
+    };
+    
+    const ChessGame& pos;
+    const MoveHistory& history;
+    uint16_t hashMove;
+    uint16_t killer1, killer2, counter;
+    bool capturesOnly;
+    int stage;
+    
+    uint16_t moves[MAX_MOVES];
+    int scores[MAX_MOVES];
+    int count, current;
+    uint16_t badCaptures[MAX_MOVES];
+    int badCount, badCurrent;
+    
+    // Swap the best remaining move to the front of what's left and take it
+    uint16_t pickBest() {
+        int best = current;
+        for (int i = current + 1; i < count; i++) {
+            if (scores[i] > scores[best]) best = i;
+        }
+        std::swap(moves[best], moves[current]);
+        std::swap(scores[best], scores[current]);
+        return moves[current++];
+    }
+    
+    bool isSpecialQuiet(uint16_t move) const {
+        return move == hashMove || move == killer1 || move == killer2 || move == counter;
+    }
+    
+    // A killer or countermove from another position: usable only if quiet,
+    // not already tried and legal here
+    bool isPlayableQuiet(uint16_t move) const {
+        return move && move != hashMove && pos.isPseudoLegal(move) &&
+               !pos.isCaptureOrPromotion(move) && pos.isLegal(move);
+    }
+    
+public:
+    MovePicker(const ChessGame& position, uint16_t hash, const MoveHistory& moveHistory,
+               int ply, uint16_t previous, bool onlyCaptures)
+        : pos(position), history(moveHistory), hashMove(hash), capturesOnly(onlyCaptures),
+          stage(STAGE_HASH), count(0), current(0), badCount(0), badCurrent(0) {
+        killer1 = history.killers[ply][0];
+        killer2 = history.killers[ply][1];
+        counter = history.counterMove(previous);
+        if (counter == killer1 || counter == killer2) counter = 0;
+        if (capturesOnly) hashMove = 0;
+    }
+    
+    // Most valuable victim first, least valuable attacker among equals
+    static int mvvLva(const ChessGame& position, uint16_t move) {
+        int from = move & 63, to = (move >> 6) & 63;
+        char victim = position.board[to / SIZE][to % SIZE];
+        char attacker = position.board[from / SIZE][from % SIZE];
+        int victimValue = (victim == ' ') ? ChessGame::seeValue('Q') - ChessGame::seeValue('P') : ChessGame::seeValue(victim);
+        return victimValue * 16 - ChessGame::seeValue(attacker) / 100;
+    }
+    
+    // The next legal move, or 0 when there are none left
+    uint16_t next() {
+        switch (stage) {
+        case STAGE_HASH:
+            stage++;
+            if (hashMove && pos.isPseudoLegal(hashMove) && pos.isLegal(hashMove)) {
+                return hashMove;
+            }
+            hashMove = 0;
+            // fallthrough
+        case STAGE_INIT_CAPTURES:
+            count = pos.generateMoves(moves, ChessGame::GEN_CAPTURES);
+            for (int i = 0; i < count; i++) {
+                scores[i] = mvvLva(pos, moves[i]);
+            }
+            current = 0;
+            stage++;
+            // fallthrough
+        case STAGE_GOOD_CAPTURES:
+            while (current < count) {
+                uint16_t move = pickBest();
+                if (move == hashMove) continue;
+                if (pos.see(move) < 0) {
+                    if (!capturesOnly) badCaptures[badCount++] = move;
+                    continue;
+                }
+                if (pos.isLegal(move)) return move;
+            }
+            if (capturesOnly) {
+                stage = STAGE_DONE;
+                return 0;
+            }
+            stage++;
+            // fallthrough
+        case STAGE_KILLER_1:
+            stage++;
+            if (isPlayableQuiet(killer1)) return killer1;
+            // fallthrough
+        case STAGE_KILLER_2:
+            stage++;
+            if (killer2 != killer1 && isPlayableQuiet(killer2)) return killer2;
+            // fallthrough
+        case STAGE_COUNTER:
+            stage++;
+            if (isPlayableQuiet(counter)) return counter;
+            // fallthrough
+        case STAGE_INIT_QUIETS:
+            count = pos.generateMoves(moves, ChessGame::GEN_QUIETS);
+            for (int i = 0; i < count; i++) {
+                scores[i] = history.score(pos.currentPlayer, moves[i]);
+            }
+            current = 0;
+            stage++;
+            // fallthrough
+        case STAGE_QUIETS:
+            while (current < count) {
+                uint16_t move = pickBest();
+                if (!isSpecialQuiet(move) && pos.isLegal(move)) return move;
+            }
+            stage++;
+            // fallthrough
+        case STAGE_BAD_CAPTURES:
+            while (badCurrent < badCount) {
+                uint16_t move = badCaptures[badCurrent++];
+                if (pos.isLegal(move)) return move;
             }
+            stage++;
+            // fallthrough
+        default:
+            return 0;
         }
-        
-        // Clear move history
-        moveHistory.clear();
-        currentMoveIndex = -1;
-        currentPlayer = 'w';
-        inCheck = false;
     }
+};
 
-    std::string getBoardState() const {
-        std::string state;
-        for (int i = 0; i < SIZE; i++) {
-            for (int j = 0; j < SIZE; j++) {
-                state += board[i][j];
-            }
+// Alpha-beta searcher over ChessGame. Each instance owns a private copy of
+// the position and its transposition table, so one Searcher serves one
+// thread; stop() and ponderhit() may be called from any thread.
+class Searcher {
+public:
+    static const int MATE = 30000;
+    static const int MAX_PLY = MoveHistory::MAX_PLY;
+    static const int KNOWN_WIN = 10000;       // Bitbase wins score above this
+    static const int TABLEBASE_WIN = 20000;   // Tablebase wins, less the DTZ
+    
+    explicit Searcher(size_t hashMB = 16) : pawnTable(PAWN_TABLE_SIZE), stopRequested(false), pondering(false) {
+        setHashSize(hashMB);
+    }
+    
+    void setHashSize(size_t hashMB) {
+        size_t entries = 1;
+        while (entries * 2 * sizeof(TTEntry) <= hashMB * 1024 * 1024) {
+            entries *= 2;
         }
-        return state;
+        table.assign(entries, TTEntry());
     }
     
-    char getCurrentPlayer() const {
-        return currentPlayer;
+    // Forget everything learned in previous searches
+    void clear() {
+        std::fill(table.begin(), table.end(), TTEntry());
+        std::fill(pawnTable.begin(), pawnTable.end(), PawnEntry());
+        history.clear();
     }
     
-    bool canUndo() const {
-        return currentMoveIndex >= 0;
+    // Ask the running search to stop; it stays requested until the next
+    // prepare
+    void stop() {
+        stopRequested = true;
     }
     
-    bool canRedo() const {
-        return currentMoveIndex < (int)moveHistory.size() - 1;
+    // Clear any earlier stop and set the ponder state for the next search.
+    // Call it on the controlling thread before starting the search thread,
+    // so a stop or ponderhit sent right after is not lost.
+    void prepare(const SearchLimits& searchLimits) {
+        stopRequested = false;
+        pondering = searchLimits.ponder;
     }
     
-    bool isInCheckState() const {
-        return inCheck;
+    // The opponent played the predicted move: the clock starts now
+    void ponderhit() {
+        startTime = nowMs();
+        pondering = false;
     }
     
-    bool isCheckmate() const {
-        return inCheck && !hasLegalMoves(currentPlayer);
+    static bool isMateScore(int score) {
+        return score > MATE - MAX_PLY || score < -MATE + MAX_PLY;
     }
     
-    bool isStalemate() const {
-        return !inCheck && !hasLegalMoves(currentPlayer);
+    // Search the position and return the best move (0 if there is none).
+    // onDepth, if set, is called after every completed iteration.
+    uint16_t think(const ChessGame& game, const SearchLimits& searchLimits,
+                   const std::function<void(const SearchInfo&)>& onDepth = nullptr) {
+        beginSearch(game, searchLimits);
+        rootExcluded.clear();
+        
+        uint16_t rootMoves[MAX_MOVES];
+        int rootCount = pos.generateLegalMoves(rootMoves);
+        if (rootCount == 0) {
+            return 0;
+        }
+        
+        uint16_t bestMove = rootMoves[0];
+        int maxDepth = (limits.depth > 0) ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+        for (int depth = 1; depth <= maxDepth; depth++) {
+            CHESS_TRACE_SCOPE_ARG("searchIteration", depth);
+            int score = negamax(depth, -MATE - 1, MATE + 1, 0);
+            if (stopped) {
+                break;
+            }
+            
+            bestMove = pvTable[0][0];
+            if (onDepth) {
+                SearchInfo info;
+                info.depth = depth;
+                info.score = score;
+                info.nodes = nodes;
+                info.timeMs = nowMs() - startTime;
+                info.pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+                onDepth(info);
+            }
+            
+            // Another iteration would most likely not finish in time
+            if (!pondering && softLimit > 0 && nowMs() - startTime > softLimit / 2) {
+                break;
+            }
+            if (isMateScore(score) && MATE - std::abs(score) <= depth) {
+                break;
+            }
+        }
+        return bestMove;
     }
-
-    bool validMove(const std::string& moveStr, int& col, int& row) const {
-        if (moveStr.length() == 2 && 
-            moveStr[0] >= 'a' && moveStr[0] <= 'h' && 
-            moveStr[1] >= '1' && moveStr[1] <= '8') {
-            col = moveStr[0] - 'a';
-            row = 8 - (moveStr[1] - '0');
-            return true;
+    
+    // The best multiPV moves of the position, each with its score and
+    // principal variation, from one search: at every depth the root is
+    // searched once per line, excluding the moves of the lines before it, so
+    // all lines share the transposition table and move ordering. onDepth,
+    // if set, receives the result after every completed depth.
+    AnalysisResult analyze(const ChessGame& game, int multiPV, const SearchLimits& searchLimits,
+                           const std::function<void(const AnalysisResult&)>& onDepth = nullptr) {
+        startAnalysis(game, multiPV, searchLimits);
+        AnalysisResult result;
+        int maxDepth = (limits.depth > 0) ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+        for (int depth = 1; depth <= maxDepth; depth++) {
+            if (!analyzeDepth(depth, result)) {
+                break;
+            }
+            if (onDepth) {
+                onDepth(result);
+            }
+            if (!pondering && softLimit > 0 && nowMs() - startTime > softLimit / 2) {
+                break;
+            }
         }
-        return false;
+        return result;
     }
-
-    bool moveCheck(int fromR, int fromC, int toR, int toC, char player) const {
-        // Check if the piece belongs to the current player
-        if (board[fromR][fromC] == ' ' || 
-            (player == 'w' && islower(board[fromR][fromC])) || 
-            (player == 'b' && isupper(board[fromR][fromC]))) {
+    
+    // Step-by-step form of analyze for callers that drive the iterations
+    // themselves (the browser has no thread to run a search on)
+    void startAnalysis(const ChessGame& game, int multiPV, const SearchLimits& searchLimits) {
+        beginSearch(game, searchLimits);
+        uint16_t rootMoves[MAX_MOVES];
+        analysisLines = std::max(1, std::min(multiPV, pos.generateLegalMoves(rootMoves)));
+    }
+    
+    // Search one more depth into result; false (result untouched) if the
+    // search was stopped first or the position has no moves
+    bool analyzeDepth(int depth, AnalysisResult& result) {
+        CHESS_TRACE_SCOPE_ARG("searchIteration", depth);
+        uint16_t rootMoves[MAX_MOVES];
+        if (pos.generateLegalMoves(rootMoves) == 0) {
             return false;
         }
         
-        // Check if destination has a piece of the same color
-        if (isSameColorPiece(toR, toC, player)) {
-            return false;
+        std::vector<AnalysisLine> lines;
+        rootExcluded.clear();
+        for (int line = 0; line < analysisLines; line++) {
+            int score = negamax(depth, -MATE - 1, MATE + 1, 0);
+            if (stopped) {
+                return false;
+            }
+            AnalysisLine found;
+            found.score = score;
+            found.pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+            lines.push_back(found);
+            rootExcluded.push_back(pvTable[0][0]);
         }
-
-        char piece = board[fromR][fromC];
-        char pieceType = toupper(piece);
+        rootExcluded.clear();
+        
+        std::stable_sort(lines.begin(), lines.end(),
+                         [](const AnalysisLine& a, const AnalysisLine& b) { return a.score > b.score; });
+        result.depth = depth;
+        result.nodes = nodes;
+        result.timeMs = nowMs() - startTime;
+        result.lines = lines;
+        return true;
+    }
+    
+    uint64_t nodeCount() const {
+        return nodes;
+    }
+    
+private:
+    enum Bound : uint8_t { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+    
+    struct TTEntry {
+        uint64_t key = 0;
+        uint16_t move = 0;
+        int16_t score = 0;
+        int8_t depth = 0;
+        uint8_t bound = BOUND_NONE;
+    };
+    
+    // Pawn structure terms of one pawn configuration. The shield scores
+    // also depend on the king squares they were computed for.
+    struct PawnEntry {
+        uint64_t key = 0;
+        int16_t structure = 0;             // Passed, isolated and doubled pawns, White's view
+        int16_t shield[2] = {0, 0};        // White's and Black's king shields
+        int8_t shieldKing[2] = {-1, -1};
+    };
+    
+    static const int PAWN_TABLE_SIZE = 1 << 16;
+    
+    struct KeyEntry {
+        uint64_t key;
+        bool irreversible;         // Reached by a capture or pawn move
+    };
+    
+    ChessGame pos;
+    SearchLimits limits;
+    std::vector<TTEntry> table;
+    std::vector<PawnEntry> pawnTable;
+    std::vector<KeyEntry> keyStack;
+    uint64_t nodes;
+    bool stopped;
+    std::atomic<bool> stopRequested;
+    std::atomic<bool> pondering;
+    std::atomic<int64_t> startTime;
+    int64_t softLimit, hardLimit;
+    uint16_t pvTable[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+    MoveHistory history;
+    std::vector<uint16_t> rootExcluded;   // Moves of earlier multi-PV lines
+    int analysisLines = 1;
+    
+    // Reset the per-search state for a new root position
+    void beginSearch(const ChessGame& game, const SearchLimits& searchLimits) {
+        pos = game;
+        limits = searchLimits;
+        nodes = 0;
+        stopped = false;
+        startTime = nowMs();
+        allocateTime();
         
-        // Rook movement (horizontal or vertical)
-        if (pieceType == 'R' && (fromR == toR || fromC == toC)) {
-            return isPathClear(fromR, fromC, toR, toC);
+        // Hashes of the game so far, for repetition detection
+        keyStack.clear();
+        uint64_t key = pos.hashKey;
+        for (int i = pos.currentMoveIndex; i >= 0; i--) {
+            const ChessGame::MoveRecord& move = pos.moveHistory[i];
+            keyStack.push_back(KeyEntry{key, move.capturedPiece != ' ' || toupper(move.movedPiece) == 'P'});
+            key ^= ChessGame::moveKeyDelta(move);
         }
-
-        // Knight movement (L-shape)
-        if (pieceType == 'N' && 
-            ((abs(fromR - toR) == 1 && abs(fromC - toC) == 2) || 
-             (abs(fromR - toR) == 2 && abs(fromC - toC) == 1))) {
-            return true; // Knights can jump over pieces
+        keyStack.push_back(KeyEntry{key, true});
+        std::reverse(keyStack.begin(), keyStack.end());
+    }
+    
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    // Split the clock into a soft limit (don't start another iteration past
+    // half of it) and a hard limit (abort the search)
+    void allocateTime() {
+        softLimit = hardLimit = 0;
+        if (limits.infinite) {
+            return;
         }
-
-        // Bishop movement (diagonal)
-        if (pieceType == 'B' && (abs(fromR - toR) == abs(fromC - toC))) {
-            return isPathClear(fromR, fromC, toR, toC);
+        if (limits.movetime > 0) {
+            softLimit = hardLimit = limits.movetime;
+            return;
         }
-
-        // Queen movement (combination of rook and bishop)
-        if (pieceType == 'Q' && 
-            ((fromR == toR || fromC == toC) || (abs(fromR - toR) == abs(fromC - toC)))) {
-            return isPathClear(fromR, fromC, toR, toC);
+        int clock = (pos.currentPlayer == 'w') ? limits.wtime : limits.btime;
+        int increment = (pos.currentPlayer == 'w') ? limits.winc : limits.binc;
+        if (clock > 0) {
+            int movesLeft = (limits.movestogo > 0) ? limits.movestogo : 30;
+            softLimit = clock / movesLeft + increment * 3 / 4;
+            hardLimit = std::min<int64_t>(softLimit * 3, clock - 50);
+            softLimit = std::min(softLimit, hardLimit);
+            if (hardLimit < 1) {
+                softLimit = hardLimit = 1;
+            }
         }
-        
-        // King movement (one square in any direction)
-        if (pieceType == 'K' && abs(fromR - toR) <= 1 && abs(fromC - toC) <= 1) {
-            return true;
+    }
+    
+    void checkLimits() {
+        if (stopRequested || (limits.nodes > 0 && nodes >= limits.nodes)) {
+            stopped = true;
+        } else if (!pondering && hardLimit > 0 && nowMs() - startTime >= hardLimit) {
+            stopped = true;
         }
-
-        // Pawn movement
-        if (pieceType == 'P') {
-            int direction = (isupper(piece)) ? -1 : 1; // White moves up (-1), Black moves down (+1)
-            
-            // Forward movement (no capture)
-            if (fromC == toC && board[toR][toC] == ' ') {
-                // Single square forward
-                if (toR == fromR + direction) {
-                    return true;
-                }
-                
-                // Double square forward from starting position
-                if ((isupper(piece) && fromR == 6 && toR == 4) || 
-                    (islower(piece) && fromR == 1 && toR == 3)) {
-                    return board[fromR + direction][fromC] == ' '; // Check if path is clear
-                }
+    }
+    
+    void makeMove(uint16_t move) {
+        int from = move & 63, to = (move >> 6) & 63;
+        bool irreversible = pos.board[to / SIZE][to % SIZE] != ' ' ||
+                            toupper(pos.board[from / SIZE][from % SIZE]) == 'P';
+        pos.applyMove(from / SIZE, from % SIZE, to / SIZE, to % SIZE, false);
+        keyStack.push_back(KeyEntry{pos.hashKey, irreversible});
+    }
+    
+    void unmakeMove() {
+        pos.undoMove();
+        keyStack.pop_back();
+    }
+    
+    // The current position occurred before with no capture or pawn move since
+    bool isRepetition() const {
+        int n = (int)keyStack.size();
+        uint64_t key = keyStack[n - 1].key;
+        for (int j = n - 3; j >= 0; j -= 2) {
+            if (keyStack[j + 1].irreversible || keyStack[j + 2].irreversible) {
+                return false;
             }
-            
-            // Diagonal capture
-            if (abs(fromC - toC) == 1 && toR == fromR + direction) {
-                return board[toR][toC] != ' ' && 
-                       ((isupper(piece) && islower(board[toR][toC])) || 
-                        (islower(piece) && isupper(board[toR][toC])));
+            if (keyStack[j].key == key) {
+                return true;
             }
         }
-
         return false;
     }
-
-    bool makeMove(int fromR, int fromC, int toR, int toC) {
-        // Check if the move is valid according to chess rules
-        if (!moveCheck(fromR, fromC, toR, toC, currentPlayer)) {
-            return false;
-        }
-        
-        // Check if the move would leave the king in check
-        if (wouldBeInCheck(fromR, fromC, toR, toC, currentPlayer)) {
-            return false;
-        }
-        
-        // Record the move for undo/redo
-        MoveRecord move;
-        move.fromRow = fromR;
-        move.fromCol = fromC;
-        move.toRow = toR;
-        move.toCol = toC;
-        move.movedPiece = board[fromR][fromC];
-        move.capturedPiece = board[toR][toC];
-        move.wasPromotion = false;
-        move.promotedTo = ' ';
-        
-        // If we're not at the end of the history, truncate future moves
-        if (currentMoveIndex < (int)moveHistory.size() - 1) {
-            moveHistory.resize(currentMoveIndex + 1);
+    
+    // Pawn terms from White's view, through the pawn hash table
+    int pawnScore(int whiteKing, int blackKing, const EvalWeights& weights) {
+        CHESS_STAT_ADD(STAT_PAWN_HASH_PROBES, 1);
+        PawnEntry& entry = pawnTable[pos.pawnKey & (PAWN_TABLE_SIZE - 1)];
+        uint64_t white = 0, black = 0;
+        bool scanned = false;
+        if (entry.key == pos.pawnKey && entry.shieldKing[0] >= 0) {
+            CHESS_STAT_ADD(STAT_PAWN_HASH_HITS, 1);
+        } else {
+            white = Evaluation::pawnBits(pos, 'P');
+            black = Evaluation::pawnBits(pos, 'p');
+            scanned = true;
+            entry.key = pos.pawnKey;
+            entry.structure = (int16_t)(Evaluation::pawnStructure(white, black, true, weights, nullptr) -
+                                        Evaluation::pawnStructure(black, white, false, weights, nullptr));
+            entry.shieldKing[0] = entry.shieldKing[1] = -1;
         }
         
-        // Make the move
-        board[toR][toC] = board[fromR][fromC];
-        board[fromR][fromC] = ' ';
-        
-        // Handle pawn promotion (automatically promote to queen for simplicity)
-        if (toupper(move.movedPiece) == 'P') {
-            // White pawn reaches the top row or black pawn reaches the bottom row
-            if ((isupper(move.movedPiece) && toR == 0) || (islower(move.movedPiece) && toR == 7)) {
-                move.wasPromotion = true;
-                move.promotedTo = isupper(move.movedPiece) ? 'Q' : 'q';
-                board[toR][toC] = move.promotedTo;
+        // Shields are redone only when a king has moved
+        int kings[2] = {whiteKing, blackKing};
+        for (int side = 0; side < 2; side++) {
+            if (entry.shieldKing[side] != kings[side]) {
+                if (!scanned) {
+                    white = Evaluation::pawnBits(pos, 'P');
+                    black = Evaluation::pawnBits(pos, 'p');
+                    scanned = true;
+                }
+                entry.shield[side] = (int16_t)Evaluation::pawnShield(side == 0 ? white : black, kings[side], side == 0,
+                                                                     weights, nullptr);
+                entry.shieldKing[side] = (int8_t)kings[side];
             }
         }
-        
-        // Switch player
-        currentPlayer = (currentPlayer == 'w') ? 'b' : 'w';
-        
-        // Check if the opponent is now in check or checkmate
-        inCheck = isInCheck(currentPlayer);
-        move.wasCheck = inCheck;
-        move.wasCheckmate = isCheckmate();
-        
-        // Add the move to history
-        moveHistory.push_back(move);
-        currentMoveIndex++;
-        
-        return true;
+        return entry.structure + entry.shield[0] - entry.shield[1];
     }
     
-    bool undoMove() {
-        if (!canUndo()) {
-            return false;
+    // Material, piece-square and pawn terms (see Evaluation), from the side
+    // to move's view
+    int evaluate() {
+        const EvalWeights& weights = chessEvalWeights();
+        int kings[2];
+        int score = Evaluation::pieceTerms(pos, weights, kings, nullptr);
+        score += pawnScore(kings[0], kings[1], weights);
+        return (pos.currentPlayer == 'w') ? score : -score;
+    }
+    
+    // Score of a bitbase win (verdict 1) or loss (-1) for the side to move:
+    // above any normal evaluation, and growing as the losing king is driven
+    // to the edge and the winning king closes in, so the search keeps making
+    // progress toward mate
+    int knownWinScore(int verdict) {
+        int kings[2] = {0, 0};
+        for (int sq = 0; sq < SIZE * SIZE; sq++) {
+            char piece = pos.board[sq / SIZE][sq % SIZE];
+            if (piece == 'K') kings[0] = sq;
+            if (piece == 'k') kings[1] = sq;
         }
         
-        // Get the last move
-        const MoveRecord& move = moveHistory[currentMoveIndex];
-        
-        // Restore the board state
-        board[move.fromRow][move.fromCol] = move.movedPiece;
-        board[move.toRow][move.toCol] = move.capturedPiece;
-        
-        // Switch back to the previous player
-        currentPlayer = (currentPlayer == 'w') ? 'b' : 'w';
-        
-        // Update check status
-        inCheck = (currentMoveIndex > 0) ? moveHistory[currentMoveIndex - 1].wasCheck : false;
-        
-        // Update the current move index
-        currentMoveIndex--;
+        bool winnerIsWhite = (verdict > 0) == (pos.currentPlayer == 'w');
+        int winner = kings[winnerIsWhite ? 0 : 1], loser = kings[winnerIsWhite ? 1 : 0];
+        int edgeDistance = std::max(std::abs(2 * (loser / SIZE) - 7), std::abs(2 * (loser % SIZE) - 7));
+        int kingDistance = std::max(std::abs(winner / SIZE - loser / SIZE), std::abs(winner % SIZE - loser % SIZE));
         
-        return true;
+        int score = KNOWN_WIN + std::abs(evaluate()) + edgeDistance * 10 + (7 - kingDistance) * 10;
+        return verdict > 0 ? score : -score;
     }
     
-    bool redoMove() {
-        if (!canRedo()) {
-            return false;
+    // Captures and promotions only, until the position is quiet, so the
+    // horizon never falls in the middle of an exchange. The side to move may
+    // stand pat on the static evaluation; captures that lose material by
+    // SEE are skipped. In check every evasion is searched instead.
+    int quiescence(int alpha, int beta, int ply) {
+        pvLength[ply] = ply;
+        if ((++nodes & 1023) == 0) {
+            checkLimits();
+        }
+        if (stopped) {
+            return 0;
+        }
+        if (ply >= MAX_PLY - 1) {
+            return evaluate();
         }
         
-        // Get the next move
-        const MoveRecord& move = moveHistory[currentMoveIndex + 1];
-        
-        // Apply the move
-        board[move.toRow][move.toCol] = move.wasPromotion ? move.promotedTo : move.movedPiece;
-        board[move.fromRow][move.fromCol] = ' ';
-        
-        // Switch player
-        currentPlayer = (currentPlayer == 'w') ? 'b' : 'w';
-        
-        // Update check status
-        inCheck = move.wasCheck;
-        
-        // Update the current move index
-        currentMoveIndex++;
+        bool inCheck = pos.inCheck;
+        int bestScore = -MATE + ply;
+        if (!inCheck) {
+            bestScore = evaluate();
+            if (bestScore >= beta) {
+                return bestScore;
+            }
+            alpha = std::max(alpha, bestScore);
+        }
         
-        return true;
+        // Good captures only, unless evading check
+        MovePicker picker(pos, 0, history, ply, 0, !inCheck);
+        while (uint16_t move = picker.next()) {
+            makeMove(move);
+            int score = -quiescence(-beta, -alpha, ply + 1);
+            unmakeMove();
+            if (stopped) {
+                return 0;
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                if (score > alpha) {
+                    alpha = score;
+                    if (alpha >= beta) {
+                        break;
+                    }
+                }
+            }
+        }
+        return bestScore;
     }
-
-    bool isGameOver() const {
-        // Game is over if there's a checkmate or stalemate
-        return isCheckmate() || isStalemate() || !hasKings();
+    
+    // Mate scores are stored relative to the node, not the root
+    // Whether entry holds the current position
+    bool probeTable(const TTEntry& entry) const {
+        CHESS_TRACE_SCOPE("ttProbe");
+        return entry.key == pos.hashKey;
+    }
+    
+    static int scoreToTT(int score, int ply) {
+        return score > MATE - MAX_PLY ? score + ply : (score < -MATE + MAX_PLY ? score - ply : score);
+    }
+    
+    static int scoreFromTT(int score, int ply) {
+        return score > MATE - MAX_PLY ? score - ply : (score < -MATE + MAX_PLY ? score + ply : score);
     }
     
-    bool hasKings() const {
-        bool whiteKingFound = false;
-        bool blackKingFound = false;
+    int negamax(int depth, int alpha, int beta, int ply) {
+        pvLength[ply] = ply;
+        if ((++nodes & 1023) == 0) {
+            checkLimits();
+        }
+        if (stopped) {
+            return 0;
+        }
+        if (ply > 0 && isRepetition()) {
+            return 0;
+        }
+        if (ply >= MAX_PLY - 1) {
+            return evaluate();
+        }
         
-        for (int i = 0; i < SIZE; i++) {
-            for (int j = 0; j < SIZE; j++) {
-                if (board[i][j] == 'K') whiteKingFound = true;
-                if (board[i][j] == 'k') blackKingFound = true;
-                
-                if (whiteKingFound && blackKingFound) return true;
+        // Exact verdicts for bitbase endgames
+        if (ply > 0) {
+            int entry;
+            int verdict = pos.probeEndgame(entry);
+            if (verdict == 0) {
+                return 0;
+            }
+            if (verdict != ChessGame::BITBASE_UNKNOWN) {
+                return knownWinScore(verdict);
+            }
+            
+            // Larger tablebases: fewer plies to conversion scores higher. A
+            // side already mated (a loss at distance 0) is left to the search.
+            if (entry >= 0 && entry != 128) {
+                int dtz = ChessGame::entryDTZ(entry);
+                return dtz == 0 ? 0 : (dtz > 0 ? TABLEBASE_WIN - dtz : -TABLEBASE_WIN - dtz);
             }
         }
         
-        return whiteKingFound && blackKingFound;
-    }
-    
-    std::string getMoveHistory() const {
-        std::string history;
-        for (size_t i = 0; i < moveHistory.size(); i++) {
-            const MoveRecord& move = moveHistory[i];
-            
-            // Add move number for white's moves
-            if (i % 2 == 0) {
-                history += std::to_string(i / 2 + 1) + ". ";
+        bool inCheck = pos.inCheck;
+        if (inCheck) {
+            depth++;
+        }
+        if (depth <= 0) {
+            return quiescence(alpha, beta, ply);
+        }
+        
+        // Transposition table cutoff, only in null-window nodes so the
+        // principal variation is always searched out in full
+        bool pvNode = beta - alpha > 1;
+        TTEntry& entry = table[pos.hashKey & (table.size() - 1)];
+        uint16_t hashMove = 0;
+        if (probeTable(entry)) {
+            hashMove = entry.move;
+            int ttScore = scoreFromTT(entry.score, ply);
+            if (!pvNode && entry.depth >= depth &&
+                (entry.bound == BOUND_EXACT ||
+                 (entry.bound == BOUND_LOWER && ttScore >= beta) ||
+                 (entry.bound == BOUND_UPPER && ttScore <= alpha))) {
+                return ttScore;
             }
-            
-            // Add piece notation (except for pawns)
-            history += getPieceNotation(move.movedPiece);
-            
-            // Add source and destination squares
-            history += getSquareNotation(move.fromRow, move.fromCol);
-            
-            // Use 'x' for captures
-            if (move.capturedPiece != ' ') {
-                history += "x";
-            } else {
-                history += "-";
+        }
+        
+        // The move that led here, for the countermove heuristic
+        uint16_t previous = 0;
+        if (pos.currentMoveIndex >= 0) {
+            const ChessGame::MoveRecord& last = pos.moveHistory[pos.currentMoveIndex];
+            previous = ChessGame::encodeMove(last.fromRow, last.fromCol, last.toRow, last.toCol);
+        }
+        
+        MovePicker picker(pos, hashMove, history, ply, previous, false);
+        uint16_t quietsTried[MAX_MOVES];
+        int quietCount = 0;
+        int legalCount = 0;
+        int originalAlpha = alpha;
+        int bestScore = -MATE - 1;
+        uint16_t bestMove = 0;
+        while (uint16_t move = picker.next()) {
+            if (ply == 0 && std::find(rootExcluded.begin(), rootExcluded.end(), move) != rootExcluded.end()) {
+                continue;
             }
+            legalCount++;
+            bool quiet = !pos.isCaptureOrPromotion(move);
             
-            history += getSquareNotation(move.toRow, move.toCol);
-            
-            // Add promotion indicator
-            if (move.wasPromotion) {
-                history += "=" + std::string(1, toupper(move.promotedTo));
+            // Principal variation search: later moves only have to prove
+            // they're no better, unless the null window says otherwise
+            makeMove(move);
+            int score;
+            if (legalCount == 1) {
+                score = -negamax(depth - 1, -beta, -alpha, ply + 1);
+            } else {
+                score = -negamax(depth - 1, -alpha - 1, -alpha, ply + 1);
+                if (score > alpha && score < beta) {
+                    score = -negamax(depth - 1, -beta, -alpha, ply + 1);
+                }
             }
-            
-            // Add check/checkmate indicator
-            if (move.wasCheckmate) {
-                history += "#";
-            } else if (move.wasCheck) {
-                history += "+";
+            unmakeMove();
+            if (stopped) {
+                return 0;
             }
             
-            // Add separator
-            if (i < moveHistory.size() - 1) {
-                if (i % 2 == 0) {
-                    history += " ";  // Space between white and black moves
-                } else {
-                    history += ", ";  // Comma between move pairs
+            if (score > bestScore) {
+                bestScore = score;
+                bestMove = move;
+                if (score > alpha) {
+                    alpha = score;
+                    pvTable[ply][ply] = move;
+                    for (int k = ply + 1; k < pvLength[ply + 1]; k++) {
+                        pvTable[ply][k] = pvTable[ply + 1][k];
+                    }
+                    pvLength[ply] = pvLength[ply + 1];
+                    if (alpha >= beta) {
+                        if (quiet) {
+                            history.update(pos.currentPlayer, ply, previous, move, quietsTried, quietCount, depth);
+                        }
+                        break;
+                    }
                 }
             }
+            if (quiet) {
+                quietsTried[quietCount++] = move;
+            }
         }
-        return history;
+        if (legalCount == 0) {
+            return inCheck ? -MATE + ply : 0;
+        }
+        
+        // A root search with moves left out doesn't know the position's value
+        if (ply == 0 && !rootExcluded.empty()) {
+            return bestScore;
+        }
+        entry.key = pos.hashKey;
+        entry.move = bestMove;
+        entry.score = (int16_t)scoreToTT(bestScore, ply);
+        entry.depth = (int8_t)depth;
+        entry.bound = bestScore >= beta ? BOUND_LOWER : (bestScore > originalAlpha ? BOUND_EXACT : BOUND_UPPER);
+        return bestScore;
     }
-    
-    std::string getRawMoveHistory() const {
-        std::string history;
-        for (size_t i = 0; i < moveHistory.size(); i++) {
-            const MoveRecord& move = moveHistory[i];
-            char fromCol = 'a' + move.fromCol;
-            char fromRow = '8' - move.fromRow;
-            char toCol = 'a' + move.toCol;
-            char toRow = '8' - move.toRow;
-            
-            history += fromCol;
-            history += fromRow;
-            history += toCol;
-            history += toRow;
-            
-            if (i < moveHistory.size() - 1) {
-                history += ",";
-            }
+};
+
+inline std::string AnalysisResult::toJSON(const ChessGame& position) const {
+    std::string json = "{\"depth\":" + std::to_string(depth) + ",\"nodes\":" + std::to_string(nodes) +
+                       ",\"timeMs\":" + std::to_string(timeMs) + ",\"lines\":[";
+    for (size_t i = 0; i < lines.size(); i++) {
+        const AnalysisLine& line = lines[i];
+        if (Searcher::isMateScore(line.score)) {
+            int moves = (Searcher::MATE - std::abs(line.score) + 1) / 2;
+            json += "{\"mate\":" + std::to_string(line.score > 0 ? moves : -moves);
+        } else {
+            json += "{\"cp\":" + std::to_string(line.score);
         }
-        return history;
+        json += ",\"pv\":[";
+        ChessGame replay = position;
+        for (size_t m = 0; m < line.pv.size(); m++) {
+            json += (m > 0 ? ",\"" : "\"") + replay.moveToUCI(line.pv[m]) + "\"";
+            replay.replayTrusted(&line.pv[m], 1);
+        }
+        json += (i + 1 < lines.size()) ? "]}," : "]}";
+    }
+    return json + "]}";
+}
+
+// One-shot multi-PV analysis to a depth and/or time limit (0 = unset),
+// returned as AnalysisResult JSON
+inline std::string analyzePosition(const ChessGame& game, int multiPV, int depth, int movetimeMs) {
+    SearchLimits limits;
+    limits.depth = depth;
+    limits.movetime = movetimeMs;
+    if (depth <= 0 && movetimeMs <= 0) {
+        limits.depth = 8;
     }
+    Searcher searcher;
+    return searcher.analyze(game, multiPV, limits).toJSON(game);
+}
+
+// Incremental multi-PV analysis for the page: every nextDepth() call
+// searches one depth deeper and returns the result so far as JSON, so
+// partial results can be shown while the analysis continues
+class PositionAnalyzer {
+private:
+    Searcher searcher;
+    ChessGame position;
+    AnalysisResult result;
     
-    int getCurrentMoveIndex() const {
-        return currentMoveIndex;
+public:
+    PositionAnalyzer(const ChessGame& game, int multiPV) : position(game) {
+        searcher.startAnalysis(position, multiPV, SearchLimits());
     }
     
-    std::string getGameStatus() const {
-        if (isCheckmate()) {
-            return std::string("checkmate_") + (currentPlayer == 'w' ? "black" : "white");
-        } else if (isStalemate()) {
-            return "stalemate";
-        } else if (inCheck) {
-            return std::string("check_") + (currentPlayer == 'w' ? "white" : "black");
-        } else {
-            return "ongoing";
+    std::string nextDepth() {
+        if (result.depth < Searcher::MAX_PLY - 1) {
+            searcher.analyzeDepth(result.depth + 1, result);
         }
+        return result.toJSON(position);
+    }
+    
+    int getDepth() const {
+        return result.depth;
     }
 };
 
@@ -636,18 +3916,45 @@ public:
 //         .constructor<>()
 //         .function("initialize", &ChessGame::initialize)
 //         .function("getBoardState", &ChessGame::getBoardState)
+//         .function("loadFEN", &ChessGame::loadFEN)
+//         .function("getFEN", &ChessGame::getFEN)
 //         .function("getCurrentPlayer", &ChessGame::getCurrentPlayer)
+//         .function("getGeneration", &ChessGame::getGeneration)
+//         .function("getChangedSquares", &ChessGame::getChangedSquares)
 //         .function("makeMove", &ChessGame::makeMove)
 //         .function("undoMove", &ChessGame::undoMove)
 //         .function("redoMove", &ChessGame::redoMove)
 //         .function("isGameOver", &ChessGame::isGameOver)
 //         .function("isInCheckState", &ChessGame::isInCheckState)
+//         .function("isSquareAttacked", &ChessGame::isSquareAttacked)
+//         .function("getAttackerCount", &ChessGame::getAttackerCount)
+//         .function("getAttackOverlay", &ChessGame::getAttackOverlay)
 //         .function("isCheckmate", &ChessGame::isCheckmate)
 //         .function("isStalemate", &ChessGame::isStalemate)
 //         .function("canUndo", &ChessGame::canUndo)
 //         .function("canRedo", &ChessGame::canRedo)
 //         .function("getMoveHistory", &ChessGame::getMoveHistory)
 //         .function("getRawMoveHistory", &ChessGame::getRawMoveHistory)
+//         .function("replayTrusted", emscripten::select_overload<bool(const std::string&)>(&ChessGame::replayTrusted))
 //         .function("getCurrentMoveIndex", &ChessGame::getCurrentMoveIndex)
-//         .function("getGameStatus", &ChessGame::getGameStatus);
+//         .function("getGameStatus", &ChessGame::getGameStatus)
+//         .class_function("getStats", &ChessGame::getStats)
+//         .class_function("resetStats", &ChessGame::resetStats)
+//         .class_function("getTrace", &ChessGame::getTrace)
+//         .class_function("resetTrace", &ChessGame::resetTrace)
+//         .class_function("loadEvalWeights", &ChessGame::loadEvalWeights)
+//         .class_function("loadBitbases", &ChessGame::loadBitbases)
+//         .function("probeBitbase", &ChessGame::probeBitbase)
+//         .class_function("loadTablebases", &ChessGame::loadTablebases)
+//         .function("probeWDL", &ChessGame::probeWDL)
+//         .function("probeDTZ", &ChessGame::probeDTZ)
+//         .class_function("loadBook", &ChessGame::loadBook)
+//         .function("getBookMove", &ChessGame::getBookMove)
+//         .function("see", &ChessGame::see);
+//
+//     emscripten::function("analyzePosition", &analyzePosition);
+//     emscripten::class_<PositionAnalyzer>("PositionAnalyzer")
+//         .constructor<const ChessGame&, int>()
+//         .function("nextDepth", &PositionAnalyzer::nextDepth)
+//         .function("getDepth", &PositionAnalyzer::getDepth);
 // }
\ No newline at end of file
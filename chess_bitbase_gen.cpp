@@ -0,0 +1,89 @@
+#include <map>
+#include "endgame_gen.h"
+
+// Generates the KPK, KRK, KQK and KBNK win/draw bitbases with the retrograde
+// solver in endgame_gen.h.
+//
+// Usage: chess_bitbase_gen [output=bitbases.bin] [--threads N] [--skip-kbnk]
+//
+// White always holds the material. Each table is solved as the tablebase of
+// its split, kept in memory so later tables resolve conversions into it (KPK
+// promotions into KQK), then reduced to one bit per position: set when White
+// wins. Bitbases and tablebases share EndgameIndex, so bit and entry indices
+// are the same.
+
+// Set bits for White's wins: White to move (the first half of the table)
+// winning, or Black to move losing
+static std::vector<uint64_t> whiteWins(const std::vector<uint8_t>& entries, uint64_t& wins) {
+    std::vector<uint64_t> bits(entries.size() / 64, 0);
+    uint64_t half = entries.size() / 2;
+    wins = 0;
+    for (uint64_t idx = 0; idx < entries.size(); idx++) {
+        uint8_t entry = entries[idx];
+        if (idx < half ? (entry > 0 && entry < 128) : entry >= 128) {
+            bits[idx >> 6] |= 1ULL << (idx & 63);
+            wins++;
+        }
+    }
+    return bits;
+}
+
+int main(int argc, char* argv[]) {
+    std::string output = "bitbases.bin";
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    bool skipKBNK = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--skip-kbnk") {
+            skipKBNK = true;
+        } else if (arg[0] != '-') {
+            output = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [output] [--threads N] [--skip-kbnk]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Conversions look up the tables solved so far; captures leave dead draws
+    std::map<uint64_t, std::vector<uint8_t>> solved;
+    ConversionProbe probe = [&solved](const char* pieces, const int* squares, int count, bool whiteToMove) {
+        TablebasePosition position;
+        Tablebases::normalize(pieces, squares, count, whiteToMove, position);
+        if (Tablebases::isDeadDraw(position.key)) {
+            return 0;
+        }
+        auto it = solved.find(position.key);
+        if (it == solved.end()) {
+            return -1;
+        }
+        return (int)it->second[Tablebases::index(position, Tablebases::hasPawns(position.key))];
+    };
+
+    // KQK first: KPK promotions are resolved through it
+    Bitbases bitbases;
+    const int order[BB_TABLE_COUNT] = {BB_KQK, BB_KRK, BB_KPK, BB_KBNK};
+    for (int table : order) {
+        if (table == BB_KBNK && skipKBNK) continue;
+        uint64_t key = 0;
+        Tablebases::parseMaterial(std::string("K") + Bitbases::tablePieces(table) + "vK", key);
+
+        EndgameGenerator generator(key, threads, probe);
+        if (!generator.generate()) {
+            return 1;
+        }
+        uint64_t wins;
+        bitbases.bits[table] = whiteWins(generator.entries, wins);
+        std::cerr << Bitbases::tableName(table) << ": " << wins << " wins" << std::endl;
+        solved[key] = std::move(generator.entries);
+    }
+
+    if (!bitbases.save(output.c_str())) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return 1;
+    }
+    std::cerr << "Wrote " << output << std::endl;
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <chrono>
+#include "pgn_reader.h"
+
+// Builds an opening book (see OpeningBook in Updatedchess.cpp) from a PGN
+// game archive. Every move in the first plies of each game is counted; a
+// move scores 2 for a win of the side that played it, 1 for a draw or an
+// unknown result and 0 for a loss, and a position's weights are its moves'
+// scores scaled into 16 bits.
+//
+// Usage: chess_book_build <games.pgn> [book.bin] [--plies N] [--min-games N]
+
+// One played move before aggregation: the position's hash, the move and
+// its score
+struct BookSample {
+    uint64_t key;
+    uint16_t move;
+    uint32_t score;
+    uint32_t games;
+
+    bool operator<(const BookSample& other) const {
+        return key != other.key ? key < other.key : move < other.move;
+    }
+};
+
+// Sort and merge samples of the same position and move in place
+static void compact(std::vector<BookSample>& samples) {
+    std::sort(samples.begin(), samples.end());
+    size_t out = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (out > 0 && samples[out - 1].key == samples[i].key && samples[out - 1].move == samples[i].move) {
+            samples[out - 1].score += samples[i].score;
+            samples[out - 1].games += samples[i].games;
+        } else {
+            samples[out++] = samples[i];
+        }
+    }
+    samples.resize(out);
+}
+
+int main(int argc, char* argv[]) {
+    std::string input, output = "book.bin";
+    int maxPlies = 20;
+    uint32_t minGames = 2;
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--plies" && i + 1 < argc) {
+            maxPlies = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--min-games" && i + 1 < argc) {
+            minGames = (uint32_t)std::max(1, atoi(argv[++i]));
+        } else if (arg[0] != '-' && positional < 2) {
+            (positional++ == 0 ? input : output) = arg;
+        } else {
+            positional = 0;
+            break;
+        }
+    }
+    if (positional == 0) {
+        std::cerr << "Usage: " << argv[0] << " <games.pgn> [book.bin] [--plies N] [--min-games N]" << std::endl;
+        return 1;
+    }
+
+    PgnReader reader;
+    if (!reader.open(input.c_str())) {
+        std::cerr << "Cannot open " << input << std::endl;
+        return 1;
+    }
+
+    ChessGame game;
+    PgnGameInfo info;
+    std::vector<BookSample> samples;
+    size_t games = 0, used = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    while (reader.nextGame(game, info)) {
+        games++;
+        if (info.malformed || info.plies == 0) {
+            continue;
+        }
+        used++;
+
+        // Scores for a move by White and by Black
+        uint32_t whiteScore = 1, blackScore = 1;
+        if (info.result.equals("1-0")) {
+            whiteScore = 2;
+            blackScore = 0;
+        } else if (info.result.equals("0-1")) {
+            whiteScore = 0;
+            blackScore = 2;
+        }
+
+        // Walk back to the start, then forward through the opening plies
+        std::string raw = game.getRawMoveHistory();
+        while (game.undoMove()) {}
+        int plies = std::min<int>(maxPlies, (int)info.plies);
+        for (int ply = 0; ply < plies; ply++) {
+            const char* text = raw.c_str() + ply * 5;
+            uint16_t move = ChessGame::encodeMove('8' - text[1], text[0] - 'a', '8' - text[3], text[2] - 'a');
+            uint32_t score = (game.getCurrentPlayer() == 'w') ? whiteScore : blackScore;
+            samples.push_back({game.getHashKey(), move, score, 1});
+            game.redoMove();
+        }
+
+        // Bound memory on large archives
+        if (samples.size() >= (16u << 20)) {
+            compact(samples);
+        }
+    }
+    compact(samples);
+
+    // Keep moves seen often enough that still score; scale each position's
+    // weights so its best move gets 65535
+    std::vector<BookEntry> entries;
+    for (size_t begin = 0, end; begin < samples.size(); begin = end) {
+        uint32_t best = 0;
+        for (end = begin; end < samples.size() && samples[end].key == samples[begin].key; end++) {
+            if (samples[end].games >= minGames) best = std::max(best, samples[end].score);
+        }
+        for (size_t i = begin; i < end; i++) {
+            if (samples[i].games < minGames || samples[i].score == 0) continue;
+            uint16_t weight = (uint16_t)std::max<uint64_t>(1, (uint64_t)samples[i].score * 65535 / best);
+            entries.push_back({samples[i].key, samples[i].move, weight, samples[i].games});
+        }
+    }
+
+    // Most played first within a position
+    std::sort(entries.begin(), entries.end(), [](const BookEntry& a, const BookEntry& b) {
+        return a.key != b.key ? a.key < b.key : a.weight > b.weight;
+    });
+    if (!OpeningBook::write(output.c_str(), entries)) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Games: " << games << " (" << used << " used)" << std::endl;
+    std::cerr << "Entries: " << entries.size() << std::endl;
+    std::cerr << "Time: " << seconds << " s" << std::endl;
+    std::cerr << "Wrote " << output << std::endl;
+    return 0;
+}
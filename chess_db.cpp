@@ -0,0 +1,121 @@
+#include <chrono>
+#include <fstream>
+#include "game_db.h"
+
+// Game database tool (see game_db.h).
+//
+// Usage: chess_db build <games.txt> <games.db> [--threads N]
+//          games.txt has one game per line in getRawMoveHistory format
+//          ("e2e4,e7e5,..."), as printed by pgn_import --raw, optionally
+//          followed by a space and the result (1-0, 0-1, 1/2-1/2)
+//        chess_db query <games.db> <fen> [--limit N]
+//          lists the games that reached the position
+
+static uint8_t parseResult(const std::string& text) {
+    if (text == "1-0") return RESULT_WHITE_WINS;
+    if (text == "0-1") return RESULT_BLACK_WINS;
+    if (text == "1/2-1/2") return RESULT_DRAW;
+    return RESULT_UNKNOWN;
+}
+
+static const char* resultText(uint8_t result) {
+    static const char* const names[4] = {"*", "1-0", "0-1", "1/2-1/2"};
+    return names[result & 3];
+}
+
+static int build(const std::string& input, const std::string& output, int threads) {
+    std::ifstream in(input);
+    if (!in) {
+        std::cerr << "Cannot open " << input << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    GameDatabaseBuilder builder;
+    std::vector<int> lineNumbers;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        size_t space = line.find(' ');
+        uint8_t result = (space == std::string::npos) ? (uint8_t)RESULT_UNKNOWN : parseResult(line.substr(space + 1));
+        builder.addGame(line.substr(0, space), result);
+        lineNumbers.push_back(lineNumber);
+    }
+
+    std::vector<std::string> badMoves;
+    if (!builder.write(output.c_str(), threads, badMoves)) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return 1;
+    }
+    size_t skipped = 0;
+    for (size_t i = 0; i < badMoves.size(); i++) {
+        if (!badMoves[i].empty()) {
+            std::cerr << "Skipping line " << lineNumbers[i] << " (cannot play " << badMoves[i] << ")" << std::endl;
+            skipped++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Games: " << builder.size() - skipped << " (" << skipped << " skipped)" << std::endl;
+    std::cerr << "Time: " << seconds << " s" << std::endl;
+    std::cerr << "Wrote " << output << std::endl;
+    return 0;
+}
+
+static int query(const std::string& path, const std::string& fen, size_t limit) {
+    GameDatabase database;
+    if (!database.open(path.c_str())) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return 1;
+    }
+    ChessGame position;
+    if (!position.loadFEN(fen)) {
+        std::cerr << "Invalid FEN: " << fen << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t count;
+    const uint32_t* ids = database.findPosition(position, count);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << count << " of " << database.gameCount() << " games (" << ms << " ms)" << std::endl;
+    ChessGame game;
+    for (uint32_t i = 0; i < count && i < limit; i++) {
+        if (!database.loadGame(ids[i], game)) {
+            std::cerr << "Game " << ids[i] << " is corrupt" << std::endl;
+            continue;
+        }
+        std::cout << ids[i] << ' ' << resultText(database.game(ids[i]).result) << ' '
+                  << game.getRawMoveHistory() << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t limit = 20;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--limit" && i + 1 < argc) {
+            limit = (size_t)std::max(0, atoi(argv[++i]));
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() == 3 && args[0] == "build") {
+        return build(args[1], args[2], threads);
+    }
+    if (args.size() == 3 && args[0] == "query") {
+        return query(args[1], args[2], limit);
+    }
+    std::cerr << "Usage: " << argv[0] << " build <games.txt> <games.db> [--threads N]" << std::endl;
+    std::cerr << "       " << argv[0] << " query <games.db> <fen> [--limit N]" << std::endl;
+    return 1;
+}
@@ -0,0 +1,232 @@
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "Updatedchess.cpp"
+
+// EPD test-suite runner for catching search regressions. Every position
+// with a bm (best move) or am (avoid move) operation is searched under a
+// fixed depth or time limit; positions are spread over worker threads, each
+// with its own Searcher, and results are printed as they complete.
+//
+// Usage: chess_epd <suite.epd> [--depth N | --movetime MS] [--threads N] [--hash MB]
+//
+// A position is solved when the final best move is one of its bm moves and
+// none of its am moves. Its time to solution is the time of the earliest
+// iteration from which every later iteration's best move was correct.
+// Positions whose moves can't be parsed here (castling, say) are skipped.
+
+struct EpdPosition {
+    std::string fen;
+    std::string id;
+    std::vector<uint16_t> best;        // bm
+    std::vector<uint16_t> avoid;       // am
+};
+
+struct EpdResult {
+    bool solved = false;
+    int64_t solvedMs = -1;             // Time to solution, -1 if unsolved
+    uint64_t nodes = 0;
+    uint16_t move = 0;
+};
+
+struct EpdRun {
+    std::vector<EpdPosition> positions;
+    std::vector<EpdResult> results;
+    SearchLimits limits;
+    size_t hashMB = 16;
+
+    std::mutex lock;
+    std::atomic<size_t> nextPosition{0};
+    int done = 0;
+};
+
+// Parse one EPD line: four FEN fields, then "opcode operands;" operations.
+// Returns false (with a reason) for lines that can't be used.
+static bool parseEpd(const std::string& line, EpdPosition& position, std::string& error) {
+    std::istringstream in(line);
+    std::string fields[4];
+    for (std::string& field : fields) {
+        if (!(in >> field)) {
+            error = "too few fields";
+            return false;
+        }
+    }
+    position.fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+    ChessGame game;
+    if (!game.loadFEN(position.fen)) {
+        error = "invalid position";
+        return false;
+    }
+
+    std::string rest;
+    std::getline(in, rest);
+    size_t start = 0;
+    while (start < rest.size()) {
+        size_t end = rest.find(';', start);
+        if (end == std::string::npos) end = rest.size();
+        std::istringstream operation(rest.substr(start, end - start));
+        start = end + 1;
+
+        std::string opcode, operand;
+        if (!(operation >> opcode)) continue;
+        if (opcode == "id") {
+            std::getline(operation >> std::ws, position.id);
+            if (position.id.size() >= 2 && position.id.front() == '"' && position.id.back() == '"') {
+                position.id = position.id.substr(1, position.id.size() - 2);
+            }
+        } else if (opcode == "bm" || opcode == "am") {
+            while (operation >> operand) {
+                uint16_t move;
+                if (!game.parseSAN(operand.c_str(), operand.size(), move)) {
+                    error = "cannot play " + opcode + " " + operand;
+                    return false;
+                }
+                (opcode == "bm" ? position.best : position.avoid).push_back(move);
+            }
+        }
+    }
+    if (position.best.empty() && position.avoid.empty()) {
+        error = "no bm or am";
+        return false;
+    }
+    return true;
+}
+
+static bool isCorrect(const EpdPosition& position, uint16_t move) {
+    if (!move) return false;
+    if (!position.best.empty() &&
+        std::find(position.best.begin(), position.best.end(), move) == position.best.end()) {
+        return false;
+    }
+    return std::find(position.avoid.begin(), position.avoid.end(), move) == position.avoid.end();
+}
+
+static void worker(EpdRun& run) {
+    Searcher searcher;
+    searcher.setHashSize(run.hashMB);
+    for (size_t i = run.nextPosition++; i < run.positions.size(); i = run.nextPosition++) {
+        const EpdPosition& position = run.positions[i];
+        ChessGame game;
+        game.loadFEN(position.fen);
+        searcher.clear();
+
+        // The streak of correct iterations ending at the last one
+        EpdResult result;
+        int64_t streakStart = -1, lastMs = 0;
+        result.move = searcher.think(game, run.limits, [&](const SearchInfo& info) {
+            bool correct = !info.pv.empty() && isCorrect(position, info.pv[0]);
+            if (!correct) {
+                streakStart = -1;
+            } else if (streakStart < 0) {
+                streakStart = info.timeMs;
+            }
+            lastMs = info.timeMs;
+        });
+        result.nodes = searcher.nodeCount();
+        result.solved = isCorrect(position, result.move);
+
+        // A correct move the last iteration's PV didn't show was only found
+        // at the end of the search
+        result.solvedMs = !result.solved ? -1 : (streakStart >= 0 ? streakStart : lastMs);
+
+        std::lock_guard<std::mutex> guard(run.lock);
+        run.results[i] = result;
+        run.done++;
+        std::cout << run.done << "/" << run.positions.size() << " "
+                  << (position.id.empty() ? position.fen : position.id) << ": "
+                  << (result.move ? game.moveToUCI(result.move) : "(none)")
+                  << (result.solved ? " solved in " + std::to_string(result.solvedMs) + " ms" : " FAILED")
+                  << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    EpdRun run;
+    std::string path;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    run.limits.movetime = 1000;
+    bool usage = argc < 2;
+
+    for (int i = 1; i < argc && !usage; i++) {
+        std::string arg = argv[i];
+        if (arg == "--depth" && i + 1 < argc) {
+            run.limits.depth = std::max(1, atoi(argv[++i]));
+            run.limits.movetime = 0;
+        } else if (arg == "--movetime" && i + 1 < argc) {
+            run.limits.movetime = std::max(1, atoi(argv[++i]));
+            run.limits.depth = 0;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--hash" && i + 1 < argc) {
+            run.hashMB = (size_t)std::max(1, atoi(argv[++i]));
+        } else if (path.empty() && arg[0] != '-') {
+            path = arg;
+        } else {
+            usage = true;
+        }
+    }
+    if (usage || path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <suite.epd> [--depth N | --movetime MS] [--threads N] [--hash MB]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return 1;
+    }
+    std::string line, error;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        EpdPosition position;
+        if (!parseEpd(line, position, error)) {
+            std::cerr << "Skipping line " << lineNumber << " (" << error << ")" << std::endl;
+            continue;
+        }
+        run.positions.push_back(position);
+    }
+    if (run.positions.empty()) {
+        std::cerr << "No usable positions in " << path << std::endl;
+        return 1;
+    }
+    run.results.resize(run.positions.size());
+
+    // Tuned weights, bitbases and tablebases are optional, as in chess_uci
+    ChessGame::loadEvalWeights("weights.txt");
+    ChessGame::loadBitbases("bitbases.bin");
+    ChessGame::loadTablebases("tablebases");
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < std::min<int>(threads, (int)run.positions.size()); t++) {
+        workers.emplace_back(worker, std::ref(run));
+    }
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int solved = 0;
+    uint64_t nodes = 0;
+    int64_t solvedMs = 0;
+    for (const EpdResult& result : run.results) {
+        nodes += result.nodes;
+        if (result.solved) {
+            solved++;
+            solvedMs += result.solvedMs;
+        }
+    }
+    std::cout << "Solved: " << solved << "/" << run.positions.size() << std::endl;
+    std::cout << "Mean time to solution: " << (solved ? solvedMs / solved : 0) << " ms" << std::endl;
+    std::cout << "Nodes: " << nodes << std::endl;
+    std::cout << "Time: " << seconds << " s" << std::endl;
+    std::cout << "Nodes/second: " << (uint64_t)(nodes / std::max(seconds, 1e-3)) << " (" << workers.size()
+              << " threads)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include "Updatedchess.cpp"
+
+// Microbenchmarks for the individual ChessGame primitives. Every primitive is
+// timed separately over a fixed corpus of opening, middlegame and endgame
+// positions so a regression can be pinned on the primitive that caused it.
+//
+// Usage: chess_microbench [--csv] [--reps N] [--warmup N]
+// Output is JSON (default) or CSV: one row per primitive and game phase with
+// the median and 99th percentile time per call in nanoseconds.
+
+struct CorpusPosition {
+    const char* phase;
+    const char* fen;
+};
+
+// Castling rights are omitted on purpose; the engine doesn't play castling
+static const CorpusPosition corpus[] = {
+    {"opening", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1"},
+    {"opening", "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w - - 0 2"},
+    {"opening", "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w - - 2 3"},
+    {"opening", "rnbqkb1r/ppp1pppp/5n2/3p4/2PP4/8/PP2PPPP/RNBQKBNR w - - 1 3"},
+    {"middlegame", "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w - - 0 8"},
+    {"middlegame", "r2q1rk1/1b2bppp/p2ppn2/1p6/3NP3/1BN1B3/PPP2PPP/R2Q1RK1 w - - 0 11"},
+    {"middlegame", "2rq1rk1/pb1nbppp/1p2pn2/2pp4/2PP4/1PNBPN2/PB3PPP/2RQ1RK1 w - - 0 11"},
+    {"middlegame", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"},
+    {"endgame", "8/8/4k3/8/2p5/8/B2K4/8 w - - 0 1"},
+    {"endgame", "8/5pk1/6p1/8/3R4/6P1/5PK1/1r6 w - - 0 40"},
+    {"endgame", "8/8/1p3k2/p1p5/P1P2K2/1P6/8/8 b - - 0 45"},
+    {"endgame", "6k1/5p2/6p1/8/7P/6P1/3q1PK1/4Q3 w - - 0 50"},
+};
+static const int CORPUS_SIZE = sizeof(corpus) / sizeof(corpus[0]);
+static const char* const phases[3] = {"opening", "middlegame", "endgame"};
+
+// Keeps results observable so the timed calls aren't optimized away
+static volatile uint64_t sink;
+
+struct BenchResult {
+    std::string primitive;
+    std::string phase;
+    uint64_t callsPerRep;
+    double medianNs;
+    double p99Ns;
+};
+
+// Time body() over reps repetitions after warmup untimed ones; body returns
+// the number of primitive calls it made
+template <class Body>
+BenchResult runBench(const char* primitive, const char* phase, int warmup, int reps, Body body) {
+    for (int i = 0; i < warmup; i++) {
+        body();
+    }
+
+    std::vector<double> perCall;
+    perCall.reserve(reps);
+    uint64_t calls = 0;
+    for (int i = 0; i < reps; i++) {
+        auto start = std::chrono::steady_clock::now();
+        calls = body();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        perCall.push_back(calls > 0 ? ns / calls : 0);
+    }
+
+    std::sort(perCall.begin(), perCall.end());
+    BenchResult result;
+    result.primitive = primitive;
+    result.phase = phase;
+    result.callsPerRep = calls;
+    result.medianNs = perCall[perCall.size() / 2];
+    result.p99Ns = perCall[std::min(perCall.size() - 1, (size_t)(perCall.size() * 0.99))];
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    bool csv = false;
+    int reps = 200;
+    int warmup = 20;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--csv") {
+            csv = true;
+        } else if (arg == "--reps" && i + 1 < argc) {
+            reps = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            warmup = std::max(0, atoi(argv[++i]));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--csv] [--reps N] [--warmup N]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+
+    for (const char* phase : phases) {
+        // Load this phase's positions. Each also gets a deterministic 40-ply
+        // continuation so getMoveHistory has something to format.
+        std::vector<ChessGame> games;
+        std::vector<ChessGame> withHistory;
+        for (int p = 0; p < CORPUS_SIZE; p++) {
+            if (strcmp(corpus[p].phase, phase) != 0) {
+                continue;
+            }
+            ChessGame game;
+            if (!game.loadFEN(corpus[p].fen)) {
+                std::cerr << "Bad corpus FEN: " << corpus[p].fen << std::endl;
+                return 1;
+            }
+            games.push_back(game);
+
+            uint16_t moves[MAX_MOVES];
+            for (int ply = 0; ply < 40; ply++) {
+                int count = game.generateLegalMoves(moves);
+                if (count == 0) break;
+                game.replayTrusted(&moves[(ply * 7) % count], 1);
+            }
+            withHistory.push_back(game);
+        }
+
+        results.push_back(runBench("moveCheck", phase, warmup, reps, [&]() {
+            uint64_t calls = 0, hits = 0;
+            for (const ChessGame& game : games) {
+                char player = game.getCurrentPlayer();
+                for (int from = 0; from < SIZE * SIZE; from++) {
+                    for (int to = 0; to < SIZE * SIZE; to++) {
+                        hits += game.moveCheck(from / SIZE, from % SIZE, to / SIZE, to % SIZE, player);
+                        calls++;
+                    }
+                }
+            }
+            sink = hits;
+            return calls;
+        }));
+
+        results.push_back(runBench("isSquareUnderAttack", phase, warmup, reps, [&]() {
+            uint64_t calls = 0, hits = 0;
+            for (const ChessGame& game : games) {
+                char opponent = (game.getCurrentPlayer() == 'w') ? 'b' : 'w';
+                for (int sq = 0; sq < SIZE * SIZE; sq++) {
+                    hits += game.isSquareUnderAttack(sq / SIZE, sq % SIZE, opponent);
+                    calls++;
+                }
+            }
+            sink = hits;
+            return calls;
+        }));
+
+        results.push_back(runBench("isSquareAttacked", phase, warmup, reps, [&]() {
+            uint64_t calls = 0, hits = 0;
+            for (const ChessGame& game : games) {
+                char opponent = (game.getCurrentPlayer() == 'w') ? 'b' : 'w';
+                for (int sq = 0; sq < SIZE * SIZE; sq++) {
+                    hits += game.isSquareAttacked(sq / SIZE, sq % SIZE, opponent);
+                    calls++;
+                }
+            }
+            sink = hits;
+            return calls;
+        }));
+
+        results.push_back(runBench("isInCheck", phase, warmup, reps, [&]() {
+            uint64_t calls = 0, hits = 0;
+            for (const ChessGame& game : games) {
+                hits += game.isInCheck('w') + game.isInCheck('b');
+                calls += 2;
+            }
+            sink = hits;
+            return calls;
+        }));
+
+        // wouldBeInCheck over every legal move of each position
+        std::vector<std::vector<uint16_t>> legal;
+        for (const ChessGame& game : games) {
+            uint16_t moves[MAX_MOVES];
+            int count = game.generateLegalMoves(moves);
+            legal.push_back(std::vector<uint16_t>(moves, moves + count));
+        }
+        results.push_back(runBench("wouldBeInCheck", phase, warmup, reps, [&]() {
+            uint64_t calls = 0, hits = 0;
+            for (size_t g = 0; g < games.size(); g++) {
+                char player = games[g].getCurrentPlayer();
+                for (uint16_t move : legal[g]) {
+                    int from = move & 63, to = (move >> 6) & 63;
+                    hits += games[g].wouldBeInCheck(from / SIZE, from % SIZE, to / SIZE, to % SIZE, player);
+                    calls++;
+                }
+            }
+            sink = hits;
+            return calls;
+        }));
+
+        results.push_back(runBench("hasLegalMoves", phase, warmup, reps, [&]() {
+            uint64_t calls = 0, hits = 0;
+            for (const ChessGame& game : games) {
+                hits += game.hasLegalMoves('w') + game.hasLegalMoves('b');
+                calls += 2;
+            }
+            sink = hits;
+            return calls;
+        }));
+
+        results.push_back(runBench("getGameStatus", phase, warmup, reps, [&]() {
+            uint64_t calls = 0, length = 0;
+            for (const ChessGame& game : games) {
+                length += game.getGameStatus().size();
+                calls++;
+            }
+            sink = length;
+            return calls;
+        }));
+
+        results.push_back(runBench("getBoardState", phase, warmup, reps, [&]() {
+            uint64_t calls = 0, length = 0;
+            for (const ChessGame& game : games) {
+                length += game.getBoardState().size();
+                calls++;
+            }
+            sink = length;
+            return calls;
+        }));
+
+        results.push_back(runBench("getMoveHistory", phase, warmup, reps, [&]() {
+            uint64_t calls = 0, length = 0;
+            for (const ChessGame& game : withHistory) {
+                length += game.getMoveHistory().size();
+                calls++;
+            }
+            sink = length;
+            return calls;
+        }));
+    }
+
+    if (csv) {
+        std::cout << "primitive,phase,calls_per_rep,median_ns,p99_ns" << std::endl;
+        for (const BenchResult& r : results) {
+            std::cout << r.primitive << ',' << r.phase << ',' << r.callsPerRep << ','
+                      << r.medianNs << ',' << r.p99Ns << std::endl;
+        }
+    } else {
+        std::cout << "{\"reps\":" << reps << ",\"warmup\":" << warmup << ",\"results\":[" << std::endl;
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult& r = results[i];
+            std::cout << "  {\"primitive\":\"" << r.primitive << "\",\"phase\":\"" << r.phase
+                      << "\",\"calls_per_rep\":" << r.callsPerRep << ",\"median_ns\":" << r.medianNs
+                      << ",\"p99_ns\":" << r.p99Ns << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+        std::cout << "]}" << std::endl;
+    }
+    return 0;
+}
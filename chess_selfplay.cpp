@@ -0,0 +1,452 @@
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <sys/wait.h>
+#include "Updatedchess.cpp"
+
+// Self-play tournament runner for speed and strength regression testing.
+// Games run concurrently, one per worker thread, each on its own ChessGame
+// with a fixed time or node budget per move. Openings are drawn in order
+// from a FEN file and every opening is played twice with colours swapped.
+//
+// Usage: chess_selfplay [--engine CMD] [--engine CMD] [--openings FILE]
+//                       [--games N] [--concurrency N] [--movetime MS | --nodes N]
+//                       [--pgn FILE] [--sprt ELO0 ELO1] [--max-plies N] [--hash MB]
+//
+// An engine is a UCI command line (e.g. a chess_uci binary of another build)
+// or "builtin" for this build's Searcher in process, the default for both
+// sides. Results are from the first engine's point of view. With --sprt the
+// run stops as soon as the sequential probability ratio test (logistic Elo,
+// alpha = beta = 0.05) accepts ELO0 or ELO1. Games are adjudicated drawn on
+// threefold repetition, the fifty-move rule, bare kings or --max-plies.
+
+struct EngineStats {
+    uint64_t moves = 0;
+    uint64_t nodes = 0;
+    double searchMs = 0;      // Wall time spent waiting for the engine's moves
+};
+
+// One side of a game: the in-process Searcher or a UCI engine child process
+class Engine {
+private:
+    std::string command;
+    Searcher searcher;
+    pid_t child;
+    FILE* toEngine;
+    FILE* fromEngine;
+    uint64_t lastNodes;        // From the engine's latest info line
+
+    void send(const std::string& line) {
+        fputs(line.c_str(), toEngine);
+        fputc('\n', toEngine);
+        fflush(toEngine);
+    }
+
+    // Read lines until one starts with prefix; false if the engine died
+    bool waitFor(const char* prefix, std::string& line) {
+        char* buffer = nullptr;
+        size_t capacity = 0;
+        ssize_t length;
+        bool found = false;
+        while (!found && (length = getline(&buffer, &capacity, fromEngine)) >= 0) {
+            line.assign(buffer, length);
+            while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+            found = line.compare(0, strlen(prefix), prefix) == 0;
+
+            size_t at = line.find(" nodes ");
+            if (!found && line.compare(0, 5, "info ") == 0 && at != std::string::npos) {
+                lastNodes = strtoull(line.c_str() + at + 7, nullptr, 10);
+            }
+        }
+        free(buffer);
+        return found;
+    }
+
+public:
+    Engine(const std::string& engineCommand, size_t hashMB)
+        : command(engineCommand), searcher(engineCommand == "builtin" ? hashMB : 1),
+          child(-1), toEngine(nullptr), fromEngine(nullptr), lastNodes(0) {}
+
+    ~Engine() {
+        if (child > 0) {
+            send("quit");
+            fclose(toEngine);
+            fclose(fromEngine);
+            waitpid(child, nullptr, 0);
+        }
+    }
+
+    bool isBuiltin() const {
+        return command == "builtin";
+    }
+
+    // Start the child process and wait for uciok
+    bool start(size_t hashMB) {
+        if (isBuiltin()) {
+            return true;
+        }
+        int input[2], output[2];
+        if (pipe(input) != 0 || pipe(output) != 0) {
+            return false;
+        }
+        child = fork();
+        if (child == 0) {
+            dup2(input[0], 0);
+            dup2(output[1], 1);
+            close(input[1]);
+            close(output[0]);
+            execl("/bin/sh", "sh", "-c", command.c_str(), (char*)nullptr);
+            _exit(127);
+        }
+        close(input[0]);
+        close(output[1]);
+        if (child < 0) {
+            return false;
+        }
+        toEngine = fdopen(input[1], "w");
+        fromEngine = fdopen(output[0], "r");
+
+        std::string line;
+        send("uci");
+        if (!waitFor("uciok", line)) {
+            return false;
+        }
+        send("setoption name Hash value " + std::to_string(hashMB));
+        send("setoption name OwnBook value false");
+        return true;
+    }
+
+    bool newGame() {
+        if (isBuiltin()) {
+            searcher.clear();
+            return true;
+        }
+        std::string line;
+        send("ucinewgame");
+        send("isready");
+        return waitFor("readyok", line);
+    }
+
+    // Best move for game's current position in UCI notation ("" if the
+    // engine failed); nodes receives the engine's node count
+    std::string think(const ChessGame& game, const std::string& startFEN, const std::string& moves,
+                      const SearchLimits& limits, uint64_t& nodes) {
+        if (isBuiltin()) {
+            uint16_t best = searcher.think(game, limits);
+            nodes = searcher.nodeCount();
+            return best ? game.moveToUCI(best) : std::string();
+        }
+
+        std::string line;
+        send("position fen " + startFEN + (moves.empty() ? "" : " moves" + moves));
+        send(limits.nodes > 0 ? "go nodes " + std::to_string(limits.nodes)
+                              : "go movetime " + std::to_string(limits.movetime));
+        lastNodes = 0;
+        if (!waitFor("bestmove ", line)) {
+            return std::string();
+        }
+        nodes = lastNodes;
+        size_t end = line.find(' ', 9);
+        return line.substr(9, end == std::string::npos ? std::string::npos : end - 9);
+    }
+};
+
+enum GameOutcome { OUTCOME_WHITE_WINS, OUTCOME_BLACK_WINS, OUTCOME_DRAW };
+
+// Shared state of a run
+struct Tournament {
+    std::vector<std::string> engines;
+    std::vector<std::string> openings;
+    SearchLimits limits;
+    int games = 100;
+    int maxPlies = 400;
+    size_t hashMB = 16;
+    bool sprt = false;
+    double elo0 = 0, elo1 = 5;
+
+    std::ofstream pgn;
+    std::mutex lock;
+    std::atomic<int> nextGame{0};
+    std::atomic<bool> stopping{false};
+    int finished = 0;
+    int wins = 0, draws = 0, losses = 0;   // For the first engine
+    EngineStats stats[2];
+    std::chrono::steady_clock::time_point startTime;
+
+    // Log-likelihood ratio of elo1 against elo0 for the current score (the
+    // normal approximation to the trinomial GSPRT)
+    double llr() const {
+        int n = wins + draws + losses;
+        if (n == 0) return 0;
+        double score = (wins + draws * 0.5) / n;
+        double variance = (wins * (1 - score) * (1 - score) + draws * (0.5 - score) * (0.5 - score) +
+                           losses * score * score) / n;
+        if (variance <= 0) return 0;
+        double s0 = 1 / (1 + std::pow(10, -elo0 / 400)), s1 = 1 / (1 + std::pow(10, -elo1 / 400));
+        return n * (s1 - s0) * (2 * score - s0 - s1) / (2 * variance);
+    }
+
+    std::string eloText() const {
+        int n = wins + draws + losses;
+        double score = n ? (wins + draws * 0.5) / n : 0.5;
+        if (score <= 0 || score >= 1) return score <= 0 ? "-inf" : "+inf";
+        char text[32];
+        snprintf(text, sizeof(text), "%+.1f", -400 * std::log10(1 / score - 1));
+        return text;
+    }
+};
+
+static const double SPRT_LOWER = std::log(0.05 / 0.95);
+static const double SPRT_UPPER = std::log(0.95 / 0.05);
+
+// True when the board holds nothing but kings and at most one minor piece
+static bool isBareMaterial(const std::string& board) {
+    int minors = 0;
+    for (char piece : board) {
+        char type = toupper(piece);
+        if (type == 'P' || type == 'R' || type == 'Q') return false;
+        if (type == 'B' || type == 'N') minors++;
+    }
+    return minors <= 1;
+}
+
+// Play one game; white and black index the run's engines
+static GameOutcome playGame(Tournament& run, Engine* players[2], int white, const std::string& fen,
+                            ChessGame& game, std::string& termination) {
+    game.loadFEN(fen);
+    std::string startFEN = game.getFEN();
+    std::string moves;
+    std::vector<uint64_t> keys(1, game.getHashKey());   // Since the last capture or pawn move
+
+    for (int ply = 0; ; ply++) {
+        std::string status = game.getGameStatus();
+        if (status == "checkmate_white") {
+            termination = "checkmate";
+            return OUTCOME_WHITE_WINS;
+        } else if (status == "checkmate_black") {
+            termination = "checkmate";
+            return OUTCOME_BLACK_WINS;
+        } else if (status == "stalemate") {
+            termination = "stalemate";
+            return OUTCOME_DRAW;
+        } else if (std::count(keys.begin(), keys.end(), keys.back()) >= 3) {
+            termination = "threefold repetition";
+            return OUTCOME_DRAW;
+        } else if (keys.size() > 100) {
+            termination = "fifty-move rule";
+            return OUTCOME_DRAW;
+        } else if (isBareMaterial(game.getBoardState())) {
+            termination = "insufficient material";
+            return OUTCOME_DRAW;
+        } else if (ply >= run.maxPlies) {
+            termination = "move limit";
+            return OUTCOME_DRAW;
+        }
+
+        int side = (game.getCurrentPlayer() == 'w') ? white : 1 - white;
+        uint64_t nodes = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::string move = players[side]->think(game, startFEN, moves, run.limits, nodes);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        {
+            std::lock_guard<std::mutex> guard(run.lock);
+            run.stats[side].moves++;
+            run.stats[side].nodes += nodes;
+            run.stats[side].searchMs += ms;
+        }
+
+        // An illegal or missing move loses
+        int fromCol, fromRow, toCol, toRow;
+        std::string board = game.getBoardState();
+        if (move.size() < 4 || !game.validMove(move.substr(0, 2), fromCol, fromRow) ||
+            !game.validMove(move.substr(2, 2), toCol, toRow) || !game.makeMove(fromRow, fromCol, toRow, toCol)) {
+            termination = "illegal move " + move + " by " + run.engines[side];
+            return (side == white) ? OUTCOME_BLACK_WINS : OUTCOME_WHITE_WINS;
+        }
+        moves += " " + move.substr(0, 4);
+        if (board[toRow * SIZE + toCol] != ' ' || toupper(board[fromRow * SIZE + fromCol]) == 'P') {
+            keys.clear();
+        }
+        keys.push_back(game.getHashKey());
+    }
+}
+
+static void recordGame(Tournament& run, int index, int white, GameOutcome outcome,
+                       const std::string& termination, const ChessGame& game) {
+    static const char* const resultText[3] = {"1-0", "0-1", "1/2-1/2"};
+    std::lock_guard<std::mutex> guard(run.lock);
+    run.finished++;
+    if (outcome == OUTCOME_DRAW) {
+        run.draws++;
+    } else if ((outcome == OUTCOME_WHITE_WINS) == (white == 0)) {
+        run.wins++;
+    } else {
+        run.losses++;
+    }
+
+    if (run.pgn.is_open()) {
+        game.writePGN(run.pgn, {{"Event", "chess_selfplay"},
+                                {"Round", std::to_string(index + 1)},
+                                {"White", run.engines[white]},
+                                {"Black", run.engines[1 - white]},
+                                {"Result", resultText[outcome]},
+                                {"Termination", termination}});
+        run.pgn.flush();
+    }
+
+    std::cerr << "Game " << index + 1 << ": " << run.engines[white] << " - " << run.engines[1 - white] << ' '
+              << resultText[outcome] << " (" << termination << ")  +" << run.wins << " =" << run.draws
+              << " -" << run.losses << "  Elo " << run.eloText();
+    if (run.sprt) {
+        double llr = run.llr();
+        std::cerr << "  LLR " << llr << " [" << SPRT_LOWER << ", " << SPRT_UPPER << "]";
+        if (llr <= SPRT_LOWER || llr >= SPRT_UPPER) {
+            run.stopping = true;
+        }
+    }
+    std::cerr << std::endl;
+}
+
+static void worker(Tournament& run) {
+    Engine first(run.engines[0], run.hashMB), second(run.engines[1], run.hashMB);
+    Engine* players[2] = {&first, &second};
+    if (!first.start(run.hashMB) || !second.start(run.hashMB)) {
+        std::cerr << "Cannot start engines" << std::endl;
+        run.stopping = true;
+        return;
+    }
+
+    ChessGame game;
+    while (!run.stopping) {
+        int index = run.nextGame++;
+        if (index >= run.games) {
+            break;
+        }
+        int white = index % 2;
+        const std::string& fen = run.openings[(index / 2) % run.openings.size()];
+        std::string termination;
+        if (!first.newGame() || !second.newGame()) {
+            std::cerr << "Engine stopped responding" << std::endl;
+            run.stopping = true;
+            break;
+        }
+        GameOutcome outcome = playGame(run, players, white, fen, game, termination);
+        recordGame(run, index, white, outcome, termination, game);
+    }
+}
+
+static void printSummary(const Tournament& run) {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run.startTime).count();
+    std::cout << "Games: " << run.finished << " in " << seconds << " s" << std::endl;
+    std::cout << "Score of " << run.engines[0] << " vs " << run.engines[1] << ": +" << run.wins << " ="
+              << run.draws << " -" << run.losses << "  Elo " << run.eloText() << std::endl;
+    if (run.sprt) {
+        double llr = run.llr();
+        std::cout << "SPRT [" << run.elo0 << ", " << run.elo1 << "]: LLR " << llr << " -> "
+                  << (llr >= SPRT_UPPER ? "H1 accepted" : llr <= SPRT_LOWER ? "H0 accepted" : "inconclusive")
+                  << std::endl;
+    }
+    for (int e = 0; e < 2; e++) {
+        const EngineStats& stats = run.stats[e];
+        double perMove = stats.moves ? stats.searchMs / stats.moves : 0;
+        double nps = stats.searchMs > 0 ? stats.nodes * 1000.0 / stats.searchMs : 0;
+        std::cout << "Engine " << e + 1 << " (" << run.engines[e] << "): " << stats.moves << " moves, "
+                  << (uint64_t)nps << " nps, " << perMove << " ms/move" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Tournament run;
+    std::string openingsPath, pgnPath;
+    int concurrency = std::max(1u, std::thread::hardware_concurrency());
+    run.limits.movetime = 100;
+    bool usage = false;
+
+    for (int i = 1; i < argc && !usage; i++) {
+        std::string arg = argv[i];
+        if (arg == "--engine" && i + 1 < argc && run.engines.size() < 2) {
+            run.engines.push_back(argv[++i]);
+        } else if (arg == "--openings" && i + 1 < argc) {
+            openingsPath = argv[++i];
+        } else if (arg == "--games" && i + 1 < argc) {
+            run.games = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--concurrency" && i + 1 < argc) {
+            concurrency = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--movetime" && i + 1 < argc) {
+            run.limits.movetime = std::max(1, atoi(argv[++i]));
+            run.limits.nodes = 0;
+        } else if (arg == "--nodes" && i + 1 < argc) {
+            run.limits.nodes = std::max(1LL, atoll(argv[++i]));
+            run.limits.movetime = 0;
+        } else if (arg == "--pgn" && i + 1 < argc) {
+            pgnPath = argv[++i];
+        } else if (arg == "--sprt" && i + 2 < argc) {
+            run.sprt = true;
+            run.elo0 = atof(argv[++i]);
+            run.elo1 = atof(argv[++i]);
+        } else if (arg == "--max-plies" && i + 1 < argc) {
+            run.maxPlies = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--hash" && i + 1 < argc) {
+            run.hashMB = (size_t)std::max(1, atoi(argv[++i]));
+        } else {
+            usage = true;
+        }
+    }
+    if (usage) {
+        std::cerr << "Usage: " << argv[0] << " [--engine CMD] [--engine CMD] [--openings FILE]" << std::endl;
+        std::cerr << "       [--games N] [--concurrency N] [--movetime MS | --nodes N]" << std::endl;
+        std::cerr << "       [--pgn FILE] [--sprt ELO0 ELO1] [--max-plies N] [--hash MB]" << std::endl;
+        return 1;
+    }
+    while (run.engines.size() < 2) {
+        run.engines.push_back("builtin");
+    }
+
+    // One FEN per line; EPD operations after the fourth field are ignored
+    if (!openingsPath.empty()) {
+        std::ifstream in(openingsPath);
+        if (!in) {
+            std::cerr << "Cannot open " << openingsPath << std::endl;
+            return 1;
+        }
+        std::string line;
+        ChessGame check;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            if (!check.loadFEN(line) || check.isGameOver()) {
+                std::cerr << "Skipping opening: " << line << std::endl;
+                continue;
+            }
+            run.openings.push_back(line);
+        }
+    }
+    if (run.openings.empty()) {
+        run.openings.push_back(ChessGame().getFEN());
+    }
+
+    if (!pgnPath.empty()) {
+        run.pgn.open(pgnPath);
+        if (!run.pgn) {
+            std::cerr << "Cannot write " << pgnPath << std::endl;
+            return 1;
+        }
+    }
+
+    // An engine that exits early must not kill the runner
+    signal(SIGPIPE, SIG_IGN);
+
+    run.startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < std::min(concurrency, run.games); t++) {
+        threads.emplace_back(worker, std::ref(run));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    printSummary(run);
+    return 0;
+}
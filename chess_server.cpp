@@ -0,0 +1,524 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Updatedchess.cpp"
+
+// In-process session manager hosting many concurrent games.
+//
+// Games live in per-shard slab pools and are addressed by a 64-bit game ID
+// (generation << 40 | shard << 32 | slot). Each shard is owned by one worker
+// thread pinned to a CPU; commands for its games go through the shard's
+// queue and are drained in batches, so games need no locking of their own.
+//
+// Usage:
+//   chess_server [--socket PATH] [--shards N]   serve the line protocol
+//   chess_server --bench GAMES [--plies N] [--shards N]
+//
+// Protocol, one command per line, one reply line each ("ok ..." / "err ..."):
+//   new | move <id> <e2e4> | undo <id> | redo <id> | fen <id> | status <id>
+//   history <id> | random <id> | close <id> | stats
+//   trace <file>   write the span timeline (builds with -DCHESS_TRACE)
+
+static const uint32_t SLAB_SIZE = 1024;
+
+// Slab allocator of ChessGame slots. Slots are recycled through a free list
+// and carry a generation so stale IDs of closed games are rejected.
+class GamePool {
+private:
+    struct Slot {
+        alignas(ChessGame) unsigned char storage[sizeof(ChessGame)];
+        uint32_t generation;
+        uint32_t nextFree;
+        bool live;
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+    uint32_t freeHead;
+    uint32_t capacity;
+    uint32_t liveCount;
+
+    static const uint32_t NO_SLOT = 0xFFFFFFFF;
+
+    Slot& slot(uint32_t index) {
+        return slabs[index / SLAB_SIZE][index % SLAB_SIZE];
+    }
+
+public:
+    GamePool() : freeHead(NO_SLOT), capacity(0), liveCount(0) {}
+
+    ~GamePool() {
+        for (uint32_t i = 0; i < capacity; i++) {
+            if (slot(i).live) {
+                reinterpret_cast<ChessGame*>(slot(i).storage)->~ChessGame();
+            }
+        }
+    }
+
+    // Allocate a game; returns its slot index and generation
+    uint32_t create(uint32_t& generation) {
+        if (freeHead == NO_SLOT) {
+            slabs.push_back(std::unique_ptr<Slot[]>(new Slot[SLAB_SIZE]));
+            for (uint32_t i = 0; i < SLAB_SIZE; i++) {
+                Slot& s = slabs.back()[i];
+                s.generation = 0;
+                s.live = false;
+                s.nextFree = (i + 1 < SLAB_SIZE) ? capacity + i + 1 : NO_SLOT;
+            }
+            freeHead = capacity;
+            capacity += SLAB_SIZE;
+        }
+
+        uint32_t index = freeHead;
+        Slot& s = slot(index);
+        freeHead = s.nextFree;
+        new (s.storage) ChessGame();
+        s.live = true;
+        s.generation = (s.generation + 1) & 0xFFFFFF;
+        generation = s.generation;
+        liveCount++;
+        return index;
+    }
+
+    ChessGame* find(uint32_t index, uint32_t generation) {
+        if (index >= capacity) {
+            return nullptr;
+        }
+        Slot& s = slot(index);
+        if (!s.live || s.generation != generation) {
+            return nullptr;
+        }
+        return reinterpret_cast<ChessGame*>(s.storage);
+    }
+
+    bool destroy(uint32_t index, uint32_t generation) {
+        ChessGame* game = find(index, generation);
+        if (!game) {
+            return false;
+        }
+        game->~ChessGame();
+        Slot& s = slot(index);
+        s.live = false;
+        s.nextFree = freeHead;
+        freeHead = index;
+        liveCount--;
+        return true;
+    }
+
+    uint32_t size() const {
+        return liveCount;
+    }
+};
+
+enum CommandType { CMD_NEW, CMD_MOVE, CMD_UNDO, CMD_REDO, CMD_FEN, CMD_STATUS,
+                   CMD_HISTORY, CMD_RANDOM, CMD_CLOSE };
+
+struct Command {
+    CommandType type;
+    uint64_t gameId;
+    int fromR, fromC, toR, toC;
+    std::promise<std::string>* reply;   // Null for fire-and-forget commands
+};
+
+static uint64_t makeGameId(uint32_t shard, uint32_t index, uint32_t generation) {
+    return ((uint64_t)generation << 40) | ((uint64_t)shard << 32) | index;
+}
+
+// A worker thread owning a pool of games and the queue feeding it
+class Shard {
+private:
+    uint32_t shardIndex;
+    GamePool pool;
+    std::mutex queueLock;
+    std::condition_variable queueReady;
+    std::vector<Command> queue;
+    bool stopping;
+    std::thread worker;
+    uint64_t rngState;
+
+public:
+    std::atomic<uint64_t> movesApplied;
+    std::atomic<uint64_t> commandsDone;
+    std::atomic<uint32_t> liveGames;
+
+    explicit Shard(uint32_t index)
+        : shardIndex(index), stopping(false), rngState(0x9E3779B97F4A7C15ULL ^ index),
+          movesApplied(0), commandsDone(0), liveGames(0) {}
+
+    void start(int cpu) {
+        worker = std::thread(&Shard::run, this);
+
+        // Pin the shard to one CPU so its games stay in that core's cache
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        pthread_setaffinity_np(worker.native_handle(), sizeof(cpus), &cpus);
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            stopping = true;
+        }
+        queueReady.notify_one();
+        worker.join();
+    }
+
+    void submit(const Command* commands, size_t count) {
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            queue.insert(queue.end(), commands, commands + count);
+        }
+        queueReady.notify_one();
+    }
+
+private:
+    void run() {
+        std::vector<Command> batch;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> guard(queueLock);
+                queueReady.wait(guard, [this] { return stopping || !queue.empty(); });
+                if (queue.empty() && stopping) {
+                    return;
+                }
+                batch.swap(queue);
+            }
+
+            for (const Command& command : batch) {
+                std::string result = execute(command);
+                if (command.reply) {
+                    command.reply->set_value(result);
+                }
+            }
+            commandsDone.fetch_add(batch.size(), std::memory_order_relaxed);
+            batch.clear();
+        }
+    }
+
+    std::string execute(const Command& command) {
+        if (command.type == CMD_NEW) {
+            uint32_t generation;
+            uint32_t index = pool.create(generation);
+            liveGames.store(pool.size(), std::memory_order_relaxed);
+            return "ok " + std::to_string(makeGameId(shardIndex, index, generation));
+        }
+
+        uint32_t index = (uint32_t)command.gameId;
+        uint32_t generation = (uint32_t)(command.gameId >> 40);
+        if (command.type == CMD_CLOSE) {
+            bool closed = pool.destroy(index, generation);
+            liveGames.store(pool.size(), std::memory_order_relaxed);
+            return closed ? "ok" : "err unknown game";
+        }
+
+        ChessGame* game = pool.find(index, generation);
+        if (!game) {
+            return "err unknown game";
+        }
+
+        switch (command.type) {
+        case CMD_MOVE:
+            if (!game->makeMove(command.fromR, command.fromC, command.toR, command.toC)) {
+                return "err illegal move";
+            }
+            movesApplied.fetch_add(1, std::memory_order_relaxed);
+            return "ok " + game->getGameStatus();
+        case CMD_RANDOM: {
+            // Pseudo-random legal move, for load generation
+            uint16_t moves[MAX_MOVES];
+            int count = game->generateLegalMoves(moves);
+            if (count == 0) {
+                return "err no legal moves";
+            }
+            rngState ^= rngState << 13;
+            rngState ^= rngState >> 7;
+            rngState ^= rngState << 17;
+            int move = moves[rngState % count];
+            int from = move & 63, to = (move >> 6) & 63;
+            game->makeMove(from / SIZE, from % SIZE, to / SIZE, to % SIZE);
+            movesApplied.fetch_add(1, std::memory_order_relaxed);
+            return "ok " + game->getGameStatus();
+        }
+        case CMD_UNDO:
+            return game->undoMove() ? "ok" : "err nothing to undo";
+        case CMD_REDO:
+            return game->redoMove() ? "ok" : "err nothing to redo";
+        case CMD_FEN:
+            return "ok " + game->getFEN();
+        case CMD_STATUS:
+            return "ok " + game->getGameStatus();
+        case CMD_HISTORY:
+            return "ok " + game->getRawMoveHistory();
+        default:
+            return "err bad command";
+        }
+    }
+};
+
+class SessionManager {
+private:
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<uint32_t> nextShard;
+
+public:
+    explicit SessionManager(uint32_t shardCount) : nextShard(0) {
+        unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        for (uint32_t i = 0; i < shardCount; i++) {
+            shards.push_back(std::unique_ptr<Shard>(new Shard(i)));
+            shards.back()->start(i % cpus);
+        }
+    }
+
+    ~SessionManager() {
+        for (auto& shard : shards) {
+            shard->stop();
+        }
+    }
+
+    size_t shardCount() const {
+        return shards.size();
+    }
+
+    Shard& shardFor(uint64_t gameId) {
+        return *shards[(gameId >> 32) & 0xFF];
+    }
+
+    // New games are spread round-robin over the shards
+    Shard& nextNewGameShard() {
+        return *shards[nextShard.fetch_add(1, std::memory_order_relaxed) % shards.size()];
+    }
+
+    // Run one command and wait for its reply
+    std::string call(Command command, Shard& shard) {
+        std::promise<std::string> reply;
+        std::future<std::string> result = reply.get_future();
+        command.reply = &reply;
+        shard.submit(&command, 1);
+        return result.get();
+    }
+
+    std::string stats() {
+        uint64_t moves = 0, games = 0;
+        for (auto& shard : shards) {
+            moves += shard->movesApplied.load(std::memory_order_relaxed);
+            games += shard->liveGames.load(std::memory_order_relaxed);
+        }
+        return "ok shards=" + std::to_string(shards.size()) + " games=" + std::to_string(games) +
+               " moves=" + std::to_string(moves);
+    }
+
+    // Dump every thread's spans as Chrome trace JSON and start afresh
+    std::string writeTrace(const std::string& path) {
+        std::string trace = ChessGame::getTrace();
+        FILE* file = path.empty() ? nullptr : fopen(path.c_str(), "w");
+        if (!file) {
+            return "err cannot write trace";
+        }
+        bool ok = fwrite(trace.data(), 1, trace.size(), file) == trace.size();
+        ok = (fclose(file) == 0) && ok;
+        ChessGame::resetTrace();
+        return ok ? "ok " + path : "err cannot write trace";
+    }
+
+    // Parse and run one protocol line
+    std::string handleLine(const std::string& line) {
+        std::istringstream in(line);
+        std::string verb, idText, moveText;
+        in >> verb >> idText >> moveText;
+
+        if (verb == "new") {
+            Command command = {CMD_NEW, 0, 0, 0, 0, 0, nullptr};
+            return call(command, nextNewGameShard());
+        }
+        if (verb == "stats") {
+            return stats();
+        }
+        if (verb == "trace") {
+            return writeTrace(idText);
+        }
+
+        Command command = {CMD_STATUS, 0, 0, 0, 0, 0, nullptr};
+        if (verb == "move") command.type = CMD_MOVE;
+        else if (verb == "undo") command.type = CMD_UNDO;
+        else if (verb == "redo") command.type = CMD_REDO;
+        else if (verb == "fen") command.type = CMD_FEN;
+        else if (verb == "status") command.type = CMD_STATUS;
+        else if (verb == "history") command.type = CMD_HISTORY;
+        else if (verb == "random") command.type = CMD_RANDOM;
+        else if (verb == "close") command.type = CMD_CLOSE;
+        else return "err unknown command";
+
+        char* end = nullptr;
+        command.gameId = strtoull(idText.c_str(), &end, 10);
+        if (idText.empty() || *end != '\0' || ((command.gameId >> 32) & 0xFF) >= shards.size()) {
+            return "err bad game id";
+        }
+
+        if (command.type == CMD_MOVE) {
+            if (moveText.length() != 4) {
+                return "err bad move";
+            }
+            command.fromC = moveText[0] - 'a';
+            command.fromR = '8' - moveText[1];
+            command.toC = moveText[2] - 'a';
+            command.toR = '8' - moveText[3];
+            if (command.fromR < 0 || command.fromR >= SIZE || command.fromC < 0 || command.fromC >= SIZE ||
+                command.toR < 0 || command.toR >= SIZE || command.toC < 0 || command.toC >= SIZE) {
+                return "err bad move";
+            }
+        }
+        return call(command, shardFor(command.gameId));
+    }
+};
+
+static void serveConnection(SessionManager* manager, int fd) {
+    std::string pending, output;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        pending.append(buffer, n);
+
+        // Answer every complete line received, then flush once
+        size_t start = 0, newline;
+        while ((newline = pending.find('\n', start)) != std::string::npos) {
+            std::string line = pending.substr(start, newline - start);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            start = newline + 1;
+            if (!line.empty()) {
+                output += manager->handleLine(line);
+                output += '\n';
+            }
+        }
+        pending.erase(0, start);
+
+        size_t written = 0;
+        while (written < output.size()) {
+            ssize_t w = write(fd, output.data() + written, output.size() - written);
+            if (w <= 0) break;
+            written += w;
+        }
+        output.clear();
+    }
+    close(fd);
+}
+
+static long residentBytes() {
+    long pages = 0, resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        fclose(statm);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+// Create GAMES games, play PLIES random moves in each through the shard
+// queues, and report moves per second and memory per game
+static int runBench(uint32_t shardCount, uint32_t games, int plies) {
+    SessionManager manager(shardCount);
+    long baseline = residentBytes();
+
+    std::vector<uint64_t> ids;
+    ids.reserve(games);
+    for (uint32_t i = 0; i < games; i++) {
+        Command command = {CMD_NEW, 0, 0, 0, 0, 0, nullptr};
+        std::string reply = manager.call(command, manager.nextNewGameShard());
+        ids.push_back(strtoull(reply.c_str() + 3, nullptr, 10));
+    }
+
+    // One batch per shard per ply
+    std::vector<std::vector<Command>> batches(shardCount);
+    uint64_t submitted = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int ply = 0; ply < plies; ply++) {
+        for (uint64_t id : ids) {
+            Command command = {CMD_RANDOM, id, 0, 0, 0, 0, nullptr};
+            batches[(id >> 32) & 0xFF].push_back(command);
+        }
+        for (uint32_t s = 0; s < shardCount; s++) {
+            manager.shardFor((uint64_t)s << 32).submit(batches[s].data(), batches[s].size());
+            submitted += batches[s].size();
+            batches[s].clear();
+        }
+    }
+
+    // Wait for the queues to drain
+    while (true) {
+        uint64_t done = 0;
+        for (uint32_t s = 0; s < shardCount; s++) {
+            done += manager.shardFor((uint64_t)s << 32).commandsDone.load(std::memory_order_relaxed);
+        }
+        if (done >= submitted + games) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    long used = residentBytes() - baseline;
+
+    std::string stats = manager.stats();
+    std::cout << "Shards: " << shardCount << std::endl;
+    std::cout << "Live games: " << games << std::endl;
+    std::cout << "Commands: " << submitted << " in " << seconds << " s" << std::endl;
+    std::cout << "Throughput: " << (seconds > 0 ? submitted / seconds : 0) << " moves/s" << std::endl;
+    std::cout << "Memory: " << (games ? used / (double)games : 0) << " bytes/game ("
+              << sizeof(ChessGame) << " bytes/game object)" << std::endl;
+    std::cout << stats << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string socketPath = "/tmp/chess_server.sock";
+    uint32_t shardCount = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t benchGames = 0;
+    int benchPlies = 40;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (arg == "--shards" && i + 1 < argc) {
+            shardCount = std::min(256, std::max(1, atoi(argv[++i])));
+        } else if (arg == "--bench" && i + 1 < argc) {
+            benchGames = (uint32_t)atoi(argv[++i]);
+        } else if (arg == "--plies" && i + 1 < argc) {
+            benchPlies = atoi(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--socket PATH] [--shards N] [--bench GAMES [--plies N]]" << std::endl;
+            return 1;
+        }
+    }
+    shardCount = std::min(shardCount, 256u);
+
+    if (benchGames > 0) {
+        return runBench(shardCount, benchGames, benchPlies);
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    unlink(socketPath.c_str());
+    if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        std::cerr << "Cannot listen on " << socketPath << std::endl;
+        return 1;
+    }
+
+    SessionManager manager(shardCount);
+    std::cerr << "Serving " << shardCount << " shards on " << socketPath << std::endl;
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) continue;
+        std::thread(serveConnection, &manager, client).detach();
+    }
+}
@@ -0,0 +1,112 @@
+#include <random>
+#include "Updatedchess.cpp"
+
+// Checks ChessGame::serialize / deserialize. Random games (some reaching
+// promotions) are snapshotted part-way through their undo history and
+// restored; the copy must then match the original through every redo and
+// undo. Every single-byte corruption of a snapshot's move records must be
+// either rejected, leaving the target game untouched, or restored into a
+// game that undoes and redoes safely.
+//
+// Usage: chess_snapshot_test [games]
+//
+// Exits with status 1 on the first mismatch.
+
+static bool sameGame(const ChessGame& a, const ChessGame& b) {
+    return a.getFEN() == b.getFEN() && a.getHashKey() == b.getHashKey() && a.canUndo() == b.canUndo() &&
+           a.canRedo() == b.canRedo() && a.isInCheckState() == b.isInCheckState();
+}
+
+static bool fail(const char* what, int game) {
+    std::cerr << "Game " << game << ": " << what << std::endl;
+    return false;
+}
+
+// Play up to plies random legal moves, then undo some of them
+static void playRandom(ChessGame& game, std::mt19937& rng, int plies) {
+    for (int i = 0; i < plies; i++) {
+        uint16_t moves[MAX_MOVES];
+        int count = game.generateLegalMoves(moves);
+        if (count == 0) break;
+        uint16_t move = moves[rng() % count];
+        int from = move & 63, to = (move >> 6) & 63;
+        game.makeMove(from / SIZE, from % SIZE, to / SIZE, to % SIZE);
+    }
+    int undo = rng() % (plies + 1);
+    for (int i = 0; i < undo; i++) {
+        game.undoMove();
+    }
+}
+
+static bool roundTrip(int id, ChessGame& game) {
+    std::vector<uint8_t> snapshot;
+    game.serialize(snapshot);
+    ChessGame copy;
+    if (!copy.deserialize(snapshot)) return fail("snapshot rejected", id);
+    if (!sameGame(game, copy)) return fail("restored game differs", id);
+
+    ChessGame original = game;
+    while (original.redoMove()) {
+        if (!copy.redoMove() || !sameGame(original, copy)) return fail("redo differs", id);
+    }
+    while (original.undoMove()) {
+        if (!copy.undoMove() || !sameGame(original, copy)) return fail("undo differs", id);
+    }
+    return true;
+}
+
+static bool corruption(int id, const ChessGame& game, std::mt19937& rng) {
+    std::vector<uint8_t> snapshot;
+    game.serialize(snapshot);
+    if (snapshot.size() == sizeof(GameSnapshotHeader)) return true;
+
+    // Header damage is always caught
+    std::vector<uint8_t> bad = snapshot;
+    bad[4] ^= 1;
+    ChessGame target;
+    if (target.deserialize(bad)) return fail("wrong version accepted", id);
+    bad = snapshot;
+    bad.pop_back();
+    if (target.deserialize(bad)) return fail("truncated snapshot accepted", id);
+
+    std::string before = target.getFEN();
+    for (int trial = 0; trial < 32; trial++) {
+        bad = snapshot;
+        size_t at = sizeof(GameSnapshotHeader) + rng() % (snapshot.size() - sizeof(GameSnapshotHeader));
+        bad[at] = (uint8_t)rng();
+        ChessGame restored;
+        if (!restored.deserialize(bad)) {
+            if (target.deserialize(bad) || target.getFEN() != before || target.canUndo()) {
+                return fail("rejected snapshot changed the game", id);
+            }
+            continue;
+        }
+        while (restored.undoMove()) {
+        }
+        while (restored.redoMove()) {
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? atoi(argv[1]) : 300;
+    if (games <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [games]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(7);
+    for (int id = 0; id < games; id++) {
+        ChessGame game;
+        if (id % 3 == 0) {
+            game.loadFEN("8/P6k/8/8/8/8/p6K/8 w - - 5 30");
+        }
+        playRandom(game, rng, rng() % 80);
+        if (!roundTrip(id, game) || !corruption(id, game, rng)) {
+            return 1;
+        }
+    }
+    std::cout << "Snapshots OK (" << games << " games)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "endgame_gen.h"
+
+// Builds endgame tablebases (see Tablebases in Updatedchess.cpp) with the
+// retrograde solver in endgame_gen.h, one .ctb file per material split.
+//
+// Usage: chess_tb_gen <split>... [--dir D] [--threads N]
+//   e.g. chess_tb_gen KQvK KRvK KPvK KQvKR --dir tablebases
+//
+// Captures and promotions are resolved through the smaller tables already in
+// the directory, so build them in order of increasing material.
+
+int main(int argc, char* argv[]) {
+    std::string directory = "tablebases";
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> splits;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--dir" && i + 1 < argc) {
+            directory = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else if (arg[0] != '-') {
+            splits.push_back(arg);
+        } else {
+            splits.clear();
+            break;
+        }
+    }
+    if (splits.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <split>... [--dir D] [--threads N]" << std::endl;
+        return 1;
+    }
+
+    mkdir(directory.c_str(), 0755);
+    ChessGame::loadTablebases(directory);
+    ConversionProbe probe = [](const char* pieces, const int* squares, int count, bool whiteToMove) {
+        return chessTablebases().probe(pieces, squares, count, whiteToMove);
+    };
+    for (const std::string& split : splits) {
+        uint64_t key;
+        if (!Tablebases::parseMaterial(split, key)) {
+            std::cerr << "Bad material split " << split << " (at most " << TB_MAX_PIECES << " men)" << std::endl;
+            return 1;
+        }
+        if (!Tablebases::isCanonical(key)) {
+            key = Tablebases::flipKey(key);
+        }
+        std::string name = Tablebases::materialName(key);
+        if (chessTablebases().find(key)) {
+            std::cerr << name << " already exists" << std::endl;
+            continue;
+        }
+
+        EndgameGenerator generator(key, threads, probe);
+        if (!generator.generate()) {
+            return 1;
+        }
+        std::string path = directory + "/" + name + ".ctb";
+        if (!Tablebases::write(path.c_str(), key, generator.entries) || !chessTablebases().add(path.c_str())) {
+            std::cerr << "Cannot write " << path << std::endl;
+            return 1;
+        }
+        std::cerr << "Wrote " << path << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,349 @@
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include "Updatedchess.cpp"
+
+// Fits the evaluation weights (see EvalWeights in Updatedchess.cpp) to
+// labelled positions by gradient descent on the mean squared error between
+// each game result and sigmoid(k * evaluation), after first fitting k to the
+// starting weights.
+//
+// Usage: chess_tune <positions> [weights.txt] [--epochs N] [--rate R]
+//                   [--threads N] [--limit N] [--init FILE]
+//
+// positions has one FEN per line followed by the result from White's view,
+// as 1-0 / 0-1 / 1/2-1/2 (bare or as an EPD c9 operation) or as a number
+// such as [0.5]. Quiet positions tune best.
+//
+// Every position is replayed through ChessGame once, on all threads, and
+// kept only as its sparse feature counts (Evaluation's features array) in
+// per-thread structure-of-arrays shards. Each epoch then evaluates all
+// shards in parallel, runs the sigmoid and error terms through a SIMD
+// kernel and scatters the gradient back; Adam updates the weights.
+
+typedef float FloatVec __attribute__((vector_size(32)));
+typedef int32_t IntVec __attribute__((vector_size(32)));
+static const int LANES = sizeof(FloatVec) / sizeof(float);
+
+// One thread's positions. Position i owns features [start[i], start[i + 1]).
+// The position arrays are padded to a multiple of LANES with featureless
+// draws, which add neither error nor gradient.
+struct TuningShard {
+    std::vector<uint32_t> start;
+    std::vector<uint16_t> feature;
+    std::vector<int8_t> count;
+    std::vector<float> result;
+    std::vector<float> eval;
+    std::vector<float> coeff;
+    std::vector<double> gradient;
+    double error = 0;               // Sum of squared errors
+    size_t positions = 0;           // Before padding
+
+    void pad() {
+        while (result.size() % LANES != 0) {
+            result.push_back(0.5f);
+            start.push_back((uint32_t)feature.size());
+        }
+        start.push_back((uint32_t)feature.size());
+        eval.assign(result.size(), 0);
+        coeff.assign(result.size(), 0);
+        gradient.assign(EW_COUNT, 0);
+    }
+};
+
+// Result from White's view in [0, 1], taken after the FEN's first four
+// fields; false if the line has none
+static bool parseLabel(const std::string& line, float& result) {
+    size_t at = 0;
+    for (int field = 0; field < 4 && at != std::string::npos; field++) {
+        at = line.find(' ', line.find_first_not_of(' ', at));
+    }
+    if (at == std::string::npos) {
+        return false;
+    }
+    std::string rest = line.substr(at);
+    if (rest.find("1/2-1/2") != std::string::npos) {
+        result = 0.5f;
+    } else if (rest.find("1-0") != std::string::npos) {
+        result = 1.0f;
+    } else if (rest.find("0-1") != std::string::npos) {
+        result = 0.0f;
+    } else {
+        size_t last = rest.find_last_of("0123456789.");
+        size_t first = rest.find_last_not_of("0123456789.", last);
+        if (last == std::string::npos) {
+            return false;
+        }
+        first = (first == std::string::npos) ? 0 : first + 1;
+        result = (float)atof(rest.substr(first, last - first + 1).c_str());
+        if (result < 0 || result > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Replay lines [begin, end) into a shard
+static void extractShard(const std::vector<std::string>& lines, size_t begin, size_t end, TuningShard& shard,
+                         size_t& rejected) {
+    const EvalWeights defaults;
+    ChessGame game;
+    int features[EW_COUNT];
+    for (size_t i = begin; i < end; i++) {
+        float result;
+        if (!parseLabel(lines[i], result) || !game.loadFEN(lines[i]) || !game.hasKings()) {
+            rejected++;
+            continue;
+        }
+        memset(features, 0, sizeof(features));
+        Evaluation::evaluate(game, defaults, features);
+        shard.start.push_back((uint32_t)shard.feature.size());
+        for (int f = 0; f < EW_COUNT; f++) {
+            if (features[f] != 0) {
+                shard.feature.push_back((uint16_t)f);
+                shard.count.push_back((int8_t)features[f]);
+            }
+        }
+        shard.result.push_back(result);
+        shard.positions++;
+    }
+    shard.pad();
+}
+
+// Linear evaluation of every position in the shard
+static void evaluateShard(TuningShard& shard, const float* weights) {
+    const uint32_t* start = shard.start.data();
+    const uint16_t* feature = shard.feature.data();
+    const int8_t* count = shard.count.data();
+    for (size_t i = 0; i < shard.result.size(); i++) {
+        float sum = 0;
+        for (uint32_t j = start[i]; j < start[i + 1]; j++) {
+            sum += weights[feature[j]] * count[j];
+        }
+        shard.eval[i] = sum;
+    }
+}
+
+// x = e^x, LANES at a time: 2^n * 2^f with the fraction's power from a
+// polynomial (relative error below 2e-5). In place, as vectors wider than
+// the target's registers can't be passed by value.
+static inline void expVec(FloatVec& x) {
+    FloatVec t = x * 1.44269504f;
+    t = (t < -126.0f) ? FloatVec{} - 126.0f : t;
+    t = (t > 126.0f) ? FloatVec{} + 126.0f : t;
+    IntVec n = __builtin_convertvector(t, IntVec);
+    n += (__builtin_convertvector(n, FloatVec) > t);     // Round toward -inf (true is -1)
+    FloatVec f = t - __builtin_convertvector(n, FloatVec);
+    FloatVec p = f * 1.54035e-4f + 1.33336e-3f;
+    p = p * f + 9.61813e-3f;
+    p = p * f + 5.55041e-2f;
+    p = p * f + 2.40227e-1f;
+    p = p * f + 6.93147e-1f;
+    p = p * f + 1.0f;
+    x = p * (FloatVec)((n + 127) << 23);
+}
+
+// Sigmoid and error terms of the shard: coeff receives (r - s) * s * (1 - s)
+// for s = sigmoid(k * eval), error the sum of squared errors
+static void errorKernel(TuningShard& shard, float k) {
+    const float* eval = shard.eval.data();
+    const float* result = shard.result.data();
+    float* coeff = shard.coeff.data();
+    FloatVec total = {};
+    for (size_t i = 0; i < shard.result.size(); i += LANES) {
+        FloatVec e, r;
+        memcpy(&e, eval + i, sizeof(e));
+        memcpy(&r, result + i, sizeof(r));
+        FloatVec s = e * -k;
+        expVec(s);
+        s = 1.0f / (1.0f + s);
+        FloatVec error = r - s;
+        FloatVec c = error * s * (1.0f - s);
+        memcpy(coeff + i, &c, sizeof(c));
+        total += error * error;
+    }
+    shard.error = 0;
+    for (int lane = 0; lane < LANES; lane++) {
+        shard.error += total[lane];
+    }
+}
+
+// Unscaled gradient sum over positions of coeff * count per weight
+static void gradientShard(TuningShard& shard) {
+    std::fill(shard.gradient.begin(), shard.gradient.end(), 0.0);
+    double* gradient = shard.gradient.data();
+    const uint32_t* start = shard.start.data();
+    const uint16_t* feature = shard.feature.data();
+    const int8_t* count = shard.count.data();
+    for (size_t i = 0; i < shard.result.size(); i++) {
+        double c = shard.coeff[i];
+        for (uint32_t j = start[i]; j < start[i + 1]; j++) {
+            gradient[feature[j]] += c * count[j];
+        }
+    }
+}
+
+// Run fn(shard) on every shard, one thread each
+template <class Fn>
+static void forEachShard(std::vector<TuningShard>& shards, Fn fn) {
+    std::vector<std::thread> threads;
+    for (TuningShard& shard : shards) {
+        threads.emplace_back([&shard, &fn]() { fn(shard); });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+static double meanError(const std::vector<TuningShard>& shards, size_t positions) {
+    double total = 0;
+    for (const TuningShard& shard : shards) total += shard.error;
+    return total / positions;
+}
+
+// Mean squared error of all positions for the current evaluations
+static double meanError(std::vector<TuningShard>& shards, float k, size_t positions) {
+    forEachShard(shards, [k](TuningShard& shard) { errorKernel(shard, k); });
+    return meanError(shards, positions);
+}
+
+int main(int argc, char* argv[]) {
+    std::string input, output = "weights.txt", initial;
+    int epochs = 500;
+    double rate = 1.0;
+    size_t limit = 0;
+    int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--epochs" && i + 1 < argc) {
+            epochs = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--rate" && i + 1 < argc) {
+            rate = atof(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threadCount = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--limit" && i + 1 < argc) {
+            limit = (size_t)std::max(0LL, atoll(argv[++i]));
+        } else if (arg == "--init" && i + 1 < argc) {
+            initial = argv[++i];
+        } else if (arg[0] != '-' && positional < 2) {
+            (positional++ == 0 ? input : output) = arg;
+        } else {
+            positional = 0;
+            break;
+        }
+    }
+    if (positional == 0) {
+        std::cerr << "Usage: " << argv[0] << " <positions> [weights.txt] [--epochs N] [--rate R]" << std::endl;
+        std::cerr << "       [--threads N] [--limit N] [--init FILE]" << std::endl;
+        return 1;
+    }
+    if (!initial.empty() && !ChessGame::loadEvalWeights(initial)) {
+        std::cerr << "Cannot load weights from " << initial << std::endl;
+        return 1;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(input);
+        if (!in) {
+            std::cerr << "Cannot open " << input << std::endl;
+            return 1;
+        }
+        std::string line;
+        while ((limit == 0 || lines.size() < limit) && std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty() && line[0] != '#') lines.push_back(line);
+        }
+    }
+
+    // Feature extraction, one shard per thread
+    std::vector<TuningShard> shards(threadCount);
+    std::vector<size_t> rejected(threadCount, 0);
+    {
+        std::vector<std::thread> threads;
+        size_t chunk = (lines.size() + threadCount - 1) / threadCount;
+        for (int t = 0; t < threadCount; t++) {
+            size_t begin = std::min(lines.size(), t * chunk), end = std::min(lines.size(), begin + chunk);
+            threads.emplace_back([&, begin, end, t]() {
+                extractShard(lines, begin, end, shards[t], rejected[t]);
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+    lines = std::vector<std::string>();
+    size_t positions = 0, skipped = 0, entries = 0;
+    for (int t = 0; t < threadCount; t++) {
+        positions += shards[t].positions;
+        skipped += rejected[t];
+        entries += shards[t].feature.size();
+    }
+    if (positions == 0) {
+        std::cerr << "No labelled positions in " << input << std::endl;
+        return 1;
+    }
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cerr << "Positions: " << positions << " (" << skipped << " skipped), "
+              << (double)entries / positions << " features each, " << loadSeconds << " s" << std::endl;
+
+    std::vector<float> weights(EW_COUNT);
+    for (int w = 0; w < EW_COUNT; w++) {
+        weights[w] = (float)chessEvalWeights().values[w];
+    }
+
+    // Fit the sigmoid scale to the starting weights by golden-section search
+    forEachShard(shards, [&weights](TuningShard& shard) { evaluateShard(shard, weights.data()); });
+    double low = 1e-4, high = 0.05;
+    const double golden = 0.618033988749895;
+    for (int step = 0; step < 60; step++) {
+        double a = high - golden * (high - low), b = low + golden * (high - low);
+        if (meanError(shards, (float)a, positions) < meanError(shards, (float)b, positions)) {
+            high = b;
+        } else {
+            low = a;
+        }
+    }
+    float k = (float)((low + high) / 2);
+    std::cerr << "Scale: k = " << k << ", error " << meanError(shards, k, positions) << std::endl;
+
+    // Adam over all weights but the king's material, which never counts
+    std::vector<double> m(EW_COUNT, 0), v(EW_COUNT, 0);
+    const double beta1 = 0.9, beta2 = 0.999;
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        forEachShard(shards, [&weights, k](TuningShard& shard) {
+            evaluateShard(shard, weights.data());
+            errorKernel(shard, k);
+            gradientShard(shard);
+        });
+        double error = meanError(shards, positions);
+        for (int w = 0; w < EW_COUNT; w++) {
+            if (w == EW_MATERIAL + 5) continue;
+            double gradient = 0;
+            for (const TuningShard& shard : shards) gradient += shard.gradient[w];
+            gradient *= -2.0 * k / positions;
+            m[w] = beta1 * m[w] + (1 - beta1) * gradient;
+            v[w] = beta2 * v[w] + (1 - beta2) * gradient * gradient;
+            double mHat = m[w] / (1 - std::pow(beta1, epoch)), vHat = v[w] / (1 - std::pow(beta2, epoch));
+            weights[w] -= (float)(rate * mHat / (std::sqrt(vHat) + 1e-12));
+        }
+        if (epoch % 10 == 0 || epoch == epochs) {
+            std::cerr << "Epoch " << epoch << ": error " << error << std::endl;
+        }
+    }
+
+    EvalWeights tuned;
+    for (int w = 0; w < EW_COUNT; w++) {
+        tuned.values[w] = (int)std::lround(weights[w]);
+    }
+    if (!tuned.save(output.c_str())) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cerr << "Time: " << seconds << " s" << std::endl;
+    std::cerr << "Wrote " << output << std::endl;
+    return 0;
+}
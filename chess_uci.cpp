@@ -0,0 +1,355 @@
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include "Updatedchess.cpp"
+
+// UCI front-end for the ChessGame engine. The search runs on its own thread
+// so stop, isready and ponderhit are handled the moment they arrive.
+//
+// Usage: chess_uci   (then speak UCI on stdin/stdout)
+//        chess_uci bench [depth]
+//
+// bench searches a fixed set of positions to a fixed depth (default
+// BENCH_DEPTH) on one thread with fresh tables and the built-in weights,
+// and prints the total node count and nodes per second. The node count is
+// the same on every machine for the same source, so it works as a
+// signature: any change to search or evaluation behaviour changes it.
+//
+// Besides UCI, "trace <file>" writes the span timeline of builds made with
+// -DCHESS_TRACE as Chrome trace JSON.
+
+class UciEngine {
+private:
+    ChessGame position;
+    Searcher searcher;
+    std::thread searchThread;
+    std::mutex outputLock;
+
+    // Set while a go infinite / go ponder search must hold back its bestmove
+    std::mutex releaseLock;
+    std::condition_variable releaseSignal;
+    bool holdBestMove;
+    
+    // Opening book moves are played without searching
+    bool ownBook;
+    std::mt19937 bookRandom;
+    
+    int multiPV;
+
+    // Write whole lines at once; stdout itself is fully buffered
+    void send(const std::string& line) {
+        std::lock_guard<std::mutex> guard(outputLock);
+        fwrite(line.data(), 1, line.size(), stdout);
+        fputc('\n', stdout);
+        fflush(stdout);
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> guard(releaseLock);
+            holdBestMove = false;
+        }
+        releaseSignal.notify_all();
+    }
+
+    void waitForSearch() {
+        if (searchThread.joinable()) {
+            searcher.stop();
+            release();
+            searchThread.join();
+        }
+    }
+
+    // line is the 1-based multipv index, or 0 for a single-line search
+    std::string formatInfo(const SearchInfo& info, int multiPVLine = 0) {
+        std::string line = "info depth " + std::to_string(info.depth);
+        if (multiPVLine > 0) {
+            line += " multipv " + std::to_string(multiPVLine);
+        }
+        line += " score ";
+        if (Searcher::isMateScore(info.score)) {
+            int plies = Searcher::MATE - std::abs(info.score);
+            int moves = (plies + 1) / 2;
+            line += "mate " + std::to_string(info.score > 0 ? moves : -moves);
+        } else {
+            line += "cp " + std::to_string(info.score);
+        }
+        int64_t ms = std::max<int64_t>(info.timeMs, 1);
+        line += " nodes " + std::to_string(info.nodes) +
+                " nps " + std::to_string(info.nodes * 1000 / ms) +
+                " time " + std::to_string(info.timeMs) + " pv";
+
+        ChessGame pvPosition = position;
+        for (uint16_t move : info.pv) {
+            line += " " + pvPosition.moveToUCI(move);
+            pvPosition.replayTrusted(&move, 1);
+        }
+        return line;
+    }
+
+    void setPosition(std::istringstream& in) {
+        std::string token;
+        in >> token;
+        if (token == "startpos") {
+            position.initialize();
+            in >> token;
+        } else if (token == "fen") {
+            std::string fen, part;
+            while (in >> part && part != "moves") {
+                fen += (fen.empty() ? "" : " ") + part;
+            }
+            if (!position.loadFEN(fen)) {
+                send("info string invalid fen");
+                position.initialize();
+            }
+            token = part;
+        }
+
+        if (token == "moves") {
+            std::string moveText;
+            while (in >> moveText) {
+                uint16_t move;
+                if (!position.parseSAN(moveText.c_str(), moveText.size(), move)) {
+                    send("info string illegal move " + moveText);
+                    break;
+                }
+                position.replayTrusted(&move, 1);
+            }
+        }
+    }
+
+    void go(std::istringstream& in) {
+        SearchLimits limits;
+        std::string token;
+        while (in >> token) {
+            if (token == "depth") in >> limits.depth;
+            else if (token == "nodes") in >> limits.nodes;
+            else if (token == "movetime") in >> limits.movetime;
+            else if (token == "wtime") in >> limits.wtime;
+            else if (token == "btime") in >> limits.btime;
+            else if (token == "winc") in >> limits.winc;
+            else if (token == "binc") in >> limits.binc;
+            else if (token == "movestogo") in >> limits.movestogo;
+            else if (token == "infinite") limits.infinite = true;
+            else if (token == "ponder") limits.ponder = true;
+        }
+
+        if (ownBook && !limits.infinite && !limits.ponder) {
+            uint16_t bookMove = position.pickBookMove(bookRandom());
+            if (bookMove) {
+                send("bestmove " + position.moveToUCI(bookMove));
+                return;
+            }
+        }
+        
+        holdBestMove = limits.infinite || limits.ponder;
+        searcher.prepare(limits);
+        searchThread = std::thread([this, limits]() {
+            uint16_t best;
+            if (multiPV > 1) {
+                AnalysisResult result = searcher.analyze(position, multiPV, limits, [this](const AnalysisResult& partial) {
+                    for (size_t i = 0; i < partial.lines.size(); i++) {
+                        SearchInfo info;
+                        info.depth = partial.depth;
+                        info.score = partial.lines[i].score;
+                        info.nodes = partial.nodes;
+                        info.timeMs = partial.timeMs;
+                        info.pv = partial.lines[i].pv;
+                        send(formatInfo(info, (int)i + 1));
+                    }
+                });
+                best = result.lines.empty() ? 0 : result.lines[0].pv[0];
+            } else {
+                best = searcher.think(position, limits, [this](const SearchInfo& info) {
+                    send(formatInfo(info));
+                });
+            }
+
+            // UCI forbids bestmove before stop (or ponderhit) in these modes
+            {
+                std::unique_lock<std::mutex> guard(releaseLock);
+                releaseSignal.wait(guard, [this] { return !holdBestMove; });
+            }
+            send("bestmove " + (best ? position.moveToUCI(best) : std::string("0000")));
+        });
+    }
+
+public:
+    UciEngine() : holdBestMove(false), ownBook(true), bookRandom(std::random_device()()), multiPV(1) {}
+
+    ~UciEngine() {
+        waitForSearch();
+    }
+
+    // Handle one command line; returns false on quit
+    bool handle(const std::string& line) {
+        std::istringstream in(line);
+        std::string command;
+        in >> command;
+
+        if (command == "uci") {
+            send("id name ChessGame");
+            send("id author chesspbl");
+            send("option name Hash type spin default 16 min 1 max 4096");
+            send("option name BitbaseFile type string default bitbases.bin");
+            send("option name TablebasePath type string default tablebases");
+            send("option name OwnBook type check default true");
+            send("option name MultiPV type spin default 1 min 1 max 64");
+            send("option name BookFile type string default book.bin");
+            send("option name WeightsFile type string default weights.txt");
+            send("uciok");
+        } else if (command == "isready") {
+            send("readyok");
+        } else if (command == "setoption") {
+            std::string token, name, value;
+            while (in >> token) {
+                if (token == "name") in >> name;
+                else if (token == "value") in >> value;
+            }
+            if (name == "Hash" && !value.empty()) {
+                waitForSearch();
+                searcher.setHashSize((size_t)std::max(1, atoi(value.c_str())));
+            } else if (name == "BitbaseFile") {
+                waitForSearch();
+                if (!ChessGame::loadBitbases(value)) {
+                    send("info string cannot load bitbases from " + value);
+                }
+            } else if (name == "TablebasePath") {
+                waitForSearch();
+                int tables = ChessGame::loadTablebases(value);
+                send("info string " + std::to_string(tables) + " tablebases loaded from " + value);
+            } else if (name == "MultiPV" && !value.empty()) {
+                waitForSearch();
+                multiPV = std::max(1, std::min(64, atoi(value.c_str())));
+            } else if (name == "OwnBook") {
+                ownBook = (value == "true");
+            } else if (name == "WeightsFile") {
+                waitForSearch();
+                if (ChessGame::loadEvalWeights(value)) {
+                    searcher.clear();
+                } else {
+                    send("info string cannot load weights from " + value);
+                }
+            } else if (name == "BookFile") {
+                waitForSearch();
+                if (!ChessGame::loadBook(value)) {
+                    send("info string cannot load book from " + value);
+                }
+            }
+        } else if (command == "ucinewgame") {
+            waitForSearch();
+            searcher.clear();
+            position.initialize();
+        } else if (command == "position") {
+            waitForSearch();
+            setPosition(in);
+        } else if (command == "go") {
+            waitForSearch();
+            go(in);
+        } else if (command == "stop") {
+            waitForSearch();
+        } else if (command == "ponderhit") {
+            searcher.ponderhit();
+            release();
+        } else if (command == "trace") {
+            waitForSearch();
+            std::string path;
+            in >> path;
+            FILE* file = path.empty() ? nullptr : fopen(path.c_str(), "w");
+            std::string trace = ChessGame::getTrace();
+            if (!file || fwrite(trace.data(), 1, trace.size(), file) != trace.size()) {
+                send("info string cannot write trace to " + path);
+            }
+            if (file) {
+                fclose(file);
+            }
+            ChessGame::resetTrace();
+        } else if (command == "quit") {
+            waitForSearch();
+            return false;
+        }
+        return true;
+    }
+};
+
+#define BENCH_DEPTH 6
+
+// Bench positions: openings, middlegames and endgames, some tactical
+static const char* const benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w - - 2 3",
+    "rnbqkb1r/ppp1pppp/5n2/3p4/2PP4/8/PP2PPPP/RNBQKBNR w - - 1 3",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w - - 0 8",
+    "r2q1rk1/1b2bppp/p2ppn2/1p6/3NP3/1BN1B3/PPP2PPP/R2Q1RK1 w - - 0 11",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1b2rk1/2q1b1pp/p2ppn2/1p6/3QP3/1BN1B3/PPP3PP/R4RK1 w - - 0 14",
+    "2r3k1/pp3ppp/2n5/3p4/3P4/2P2N2/P4PPP/4R1K1 b - - 0 22",
+    "r1bqk2r/pppp1ppp/2n2n2/2b1p3/2B1P3/2N2N2/PPPP1PPP/R1BQK2R w - - 4 5",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    "8/5pk1/6p1/8/3R4/6P1/5PK1/1r6 w - - 0 40",
+    "8/8/4k3/8/2p5/8/B2K4/8 w - - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1",
+};
+
+static int bench(int depth) {
+    Searcher searcher;
+    SearchLimits limits;
+    limits.depth = depth;
+    
+    uint64_t totalNodes = 0;
+    int64_t totalMs = 0;
+    int count = sizeof(benchPositions) / sizeof(benchPositions[0]);
+    for (int i = 0; i < count; i++) {
+        ChessGame game;
+        if (!game.loadFEN(benchPositions[i])) {
+            std::cerr << "Invalid bench position: " << benchPositions[i] << std::endl;
+            return 1;
+        }
+        searcher.clear();
+        SearchInfo last = SearchInfo();
+        auto start = std::chrono::steady_clock::now();
+        searcher.think(game, limits, [&last](const SearchInfo& info) {
+            last = info;
+        });
+        totalMs += std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        totalNodes += last.nodes;
+        std::cerr << "Position " << (i + 1) << "/" << count << ": " << benchPositions[i]
+                  << " nodes " << last.nodes << std::endl;
+    }
+    
+    printf("Total time (ms) : %lld\n", (long long)totalMs);
+    printf("Nodes searched  : %llu\n", (unsigned long long)totalNodes);
+    printf("Nodes/second    : %llu\n", (unsigned long long)(totalNodes * 1000 / std::max<int64_t>(1, totalMs)));
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
+    setvbuf(stdout, nullptr, _IOFBF, 1 << 16);
+    
+    // Runs before any data files are loaded so the signature never depends
+    // on what happens to be in the working directory
+    if (argc >= 2 && std::string(argv[1]) == "bench") {
+        return bench(argc >= 3 ? std::max(1, atoi(argv[2])) : BENCH_DEPTH);
+    }
+
+    // Tuned weights, endgame bitbases, tablebases and the book are
+    // optional; search works without them
+    ChessGame::loadEvalWeights("weights.txt");
+    ChessGame::loadBitbases("bitbases.bin");
+    ChessGame::loadTablebases("tablebases");
+    ChessGame::loadBook("book.bin");
+
+    UciEngine engine;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!engine.handle(line)) {
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include "chesscore.h"
+#include "Updatedchess.cpp"
+
+// libchesscore.so: the C API of chesscore.h over ChessGame. No C++
+// exception crosses the boundary: entry points that allocate catch
+// everything and return their documented failure value.
+
+struct ChessCoreGame {
+    ChessGame game;
+};
+
+int chesscore_api_version(void) {
+    return CHESSCORE_API_VERSION;
+}
+
+ChessCoreGame* chesscore_new(void) {
+    try {
+        return new ChessCoreGame();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void chesscore_free(ChessCoreGame* game) {
+    delete game;
+}
+
+void chesscore_reset(ChessCoreGame* game) {
+    game->game.initialize();
+}
+
+int chesscore_load_fen(ChessCoreGame* game, const char* fen) {
+    try {
+        return fen && game->game.loadFEN(fen);
+    } catch (...) {
+        return 0;
+    }
+}
+
+size_t chesscore_get_fen(const ChessCoreGame* game, char* buffer, size_t size) {
+    std::string fen;
+    try {
+        fen = game->game.getFEN();
+    } catch (...) {
+        // Leaves fen empty: an empty string and a length of 0
+    }
+    if (size > 0) {
+        size_t length = std::min(fen.size(), size - 1);
+        memcpy(buffer, fen.data(), length);
+        buffer[length] = '\0';
+    }
+    return fen.size();
+}
+
+char chesscore_side_to_move(const ChessCoreGame* game) {
+    return game->game.getCurrentPlayer();
+}
+
+uint64_t chesscore_hash(const ChessCoreGame* game) {
+    return game->game.getHashKey();
+}
+
+int chesscore_status(const ChessCoreGame* game) {
+    const ChessGame& position = game->game;
+    bool check = position.isInCheckState();
+    if (!position.hasLegalMoves(position.getCurrentPlayer())) {
+        return check ? CHESSCORE_CHECKMATE : CHESSCORE_STALEMATE;
+    }
+    return check ? CHESSCORE_CHECK : CHESSCORE_ONGOING;
+}
+
+uint16_t chesscore_parse_move(const char* uci) {
+    if (!uci || strlen(uci) < 4 || uci[0] < 'a' || uci[0] > 'h' || uci[1] < '1' || uci[1] > '8' ||
+        uci[2] < 'a' || uci[2] > 'h' || uci[3] < '1' || uci[3] > '8') {
+        return CHESSCORE_NO_MOVE;
+    }
+    return ChessGame::encodeMove('8' - uci[1], uci[0] - 'a', '8' - uci[3], uci[2] - 'a');
+}
+
+void chesscore_format_move(uint16_t move, char* out) {
+    int from = move & 63, to = (move >> 6) & 63;
+    out[0] = 'a' + from % SIZE;
+    out[1] = '8' - from / SIZE;
+    out[2] = 'a' + to % SIZE;
+    out[3] = '8' - to / SIZE;
+    out[4] = '\0';
+}
+
+int chesscore_make_move(ChessCoreGame* game, uint16_t move) {
+    if (move >> 12) {
+        return 0;
+    }
+    int from = move & 63, to = (move >> 6) & 63;
+    try {
+        game->game.reserveHistory(1);
+    } catch (...) {
+        return 0;
+    }
+    return game->game.makeMove(from / SIZE, from % SIZE, to / SIZE, to % SIZE);
+}
+
+int chesscore_undo(ChessCoreGame* game) {
+    return game->game.undoMove();
+}
+
+int chesscore_redo(ChessCoreGame* game) {
+    return game->game.redoMove();
+}
+
+int chesscore_legal_moves(const ChessCoreGame* game, uint16_t* moves, int capacity) {
+    uint16_t all[MAX_MOVES];
+    int count = game->game.generateLegalMoves(all);
+    memcpy(moves, all, std::max(0, std::min(count, capacity)) * sizeof(uint16_t));
+    return count;
+}
+
+size_t chesscore_serialize(const ChessCoreGame* game, uint8_t* buffer, size_t size) {
+    std::vector<uint8_t> snapshot;
+    try {
+        game->game.serialize(snapshot);
+    } catch (...) {
+        return 0;
+    }
+    if (snapshot.size() <= size) {
+        memcpy(buffer, snapshot.data(), snapshot.size());
+    }
+    return snapshot.size();
+}
+
+int chesscore_deserialize(ChessCoreGame* game, const uint8_t* data, size_t size) {
+    try {
+        return data && game->game.deserialize(data, size);
+    } catch (...) {
+        return 0;
+    }
+}
+
+int chesscore_play_moves(ChessCoreGame* game, const uint16_t* moves, int count) {
+    int played = 0;
+    while (played < count && chesscore_make_move(game, moves[played])) {
+        played++;
+    }
+    return played;
+}
+
+int chesscore_load_fen_batch(ChessCoreGame* const* games, const char* const* fens, int count, uint8_t* results) {
+    int loaded = 0;
+    for (int i = 0; i < count; i++) {
+        int ok = chesscore_load_fen(games[i], fens[i]);
+        if (results) results[i] = (uint8_t)ok;
+        loaded += ok;
+    }
+    return loaded;
+}
+
+int chesscore_make_move_batch(ChessCoreGame* const* games, const uint16_t* moves, int count, uint8_t* results) {
+    int played = 0;
+    for (int i = 0; i < count; i++) {
+        int ok = chesscore_make_move(games[i], moves[i]);
+        if (results) results[i] = (uint8_t)ok;
+        played += ok;
+    }
+    return played;
+}
+
+void chesscore_status_batch(ChessCoreGame* const* games, int count, int* statuses) {
+    for (int i = 0; i < count; i++) {
+        statuses[i] = chesscore_status(games[i]);
+    }
+}
+
+int chesscore_legal_moves_batch(ChessCoreGame* const* games, int count, uint16_t* moves, int capacity,
+                                int* offsets) {
+    int total = 0;
+    uint16_t all[MAX_MOVES];
+    offsets[0] = 0;
+    for (int i = 0; i < count; i++) {
+        int n = games[i]->game.generateLegalMoves(all);
+        if (total + n > capacity) {
+            return -1;
+        }
+        memcpy(moves + total, all, n * sizeof(uint16_t));
+        total += n;
+        offsets[i + 1] = total;
+    }
+    return total;
+}
@@ -0,0 +1,114 @@
+#ifndef CHESSCORE_H
+#define CHESSCORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Stable C API over ChessGame, for linking from C, Go, Python (ctypes/cffi)
+// and anything else with a C FFI. Only the chesscore_* functions below are
+// exported; the C++ inside is not part of the ABI.
+//
+// Build: g++ -std=c++17 -O2 -shared -fPIC -fvisibility=hidden chesscore.cpp -o libchesscore.so
+//
+// Moves are packed as uint16_t: from square in bits 0-5, to square in bits
+// 6-11, squares numbered row * 8 + col with row 0 = rank 8 (so a8 = 0,
+// h1 = 63). Pawns reaching the last rank always become queens. Functions
+// returning int report 1 for success and 0 for failure unless noted.
+// Games are not thread-safe; distinct games may be used from any threads.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHESSCORE_API __attribute__((visibility("default")))
+#define CHESSCORE_API_VERSION 1
+#define CHESSCORE_MAX_MOVES 256      // Enough for the legal moves of any position
+#define CHESSCORE_NO_MOVE 0xFFFF
+
+typedef struct ChessCoreGame ChessCoreGame;
+
+enum ChessCoreStatus {
+    CHESSCORE_ONGOING = 0,
+    CHESSCORE_CHECK = 1,             // The side to move is in check
+    CHESSCORE_CHECKMATE = 2,         // The side to move is mated
+    CHESSCORE_STALEMATE = 3
+};
+
+// CHESSCORE_API_VERSION of the loaded library
+CHESSCORE_API int chesscore_api_version(void);
+
+// A new game at the initial position, or NULL when out of memory
+CHESSCORE_API ChessCoreGame* chesscore_new(void);
+CHESSCORE_API void chesscore_free(ChessCoreGame* game);
+CHESSCORE_API void chesscore_reset(ChessCoreGame* game);
+
+// Replaces the position and clears the history; on failure (a bad FEN or
+// no memory) the game is unchanged. The castling and en passant fields are ignored; the move
+// counters are kept and carried on by chesscore_get_fen.
+CHESSCORE_API int chesscore_load_fen(ChessCoreGame* game, const char* fen);
+
+// Writes the FEN, NUL-terminated and truncated to size bytes; returns its
+// full length like snprintf, or writes "" and returns 0 when out of memory
+CHESSCORE_API size_t chesscore_get_fen(const ChessCoreGame* game, char* buffer, size_t size);
+
+// 'w' or 'b'
+CHESSCORE_API char chesscore_side_to_move(const ChessCoreGame* game);
+CHESSCORE_API uint64_t chesscore_hash(const ChessCoreGame* game);
+CHESSCORE_API int chesscore_status(const ChessCoreGame* game);
+
+// Packed form of a UCI move such as "e2e4" (a promotion suffix is
+// ignored), or CHESSCORE_NO_MOVE if malformed
+CHESSCORE_API uint16_t chesscore_parse_move(const char* uci);
+
+// UCI text of a packed move into out (at least 5 bytes)
+CHESSCORE_API void chesscore_format_move(uint16_t move, char* out);
+
+// Plays a move if it is legal and there is memory to record it
+CHESSCORE_API int chesscore_make_move(ChessCoreGame* game, uint16_t move);
+CHESSCORE_API int chesscore_undo(ChessCoreGame* game);
+CHESSCORE_API int chesscore_redo(ChessCoreGame* game);
+
+// Legal moves of the side to move into moves (capacity entries); returns
+// how many there are, which may exceed capacity
+CHESSCORE_API int chesscore_legal_moves(const ChessCoreGame* game, uint16_t* moves, int capacity);
+
+// Binary snapshot of the whole game, history and undone moves included,
+// for checkpointing. Writes it to buffer if it fits in size bytes and
+// returns its full length either way, or 0 when out of memory.
+CHESSCORE_API size_t chesscore_serialize(const ChessCoreGame* game, uint8_t* buffer, size_t size);
+
+// Restores a snapshot from chesscore_serialize without replaying its
+// moves; on failure (a bad snapshot or no memory) the game is unchanged
+CHESSCORE_API int chesscore_deserialize(ChessCoreGame* game, const uint8_t* data, size_t size);
+
+// Batch entry points, one FFI call for many games or moves
+
+// Plays count moves in order on one game, stopping at the first illegal
+// one; returns how many were played
+CHESSCORE_API int chesscore_play_moves(ChessCoreGame* game, const uint16_t* moves, int count);
+
+// Loads fens[i] into games[i]; results[i] (optional) receives 1 or 0.
+// Returns the number loaded.
+CHESSCORE_API int chesscore_load_fen_batch(ChessCoreGame* const* games, const char* const* fens, int count,
+                                           uint8_t* results);
+
+// Plays moves[i] on games[i]; results[i] (optional) receives 1 or 0.
+// Returns the number played.
+CHESSCORE_API int chesscore_make_move_batch(ChessCoreGame* const* games, const uint16_t* moves, int count,
+                                            uint8_t* results);
+
+// statuses[i] = chesscore_status(games[i])
+CHESSCORE_API void chesscore_status_batch(ChessCoreGame* const* games, int count, int* statuses);
+
+// Legal moves of every game into one array: game i's moves are
+// moves[offsets[i]] .. moves[offsets[i + 1] - 1], so offsets holds count + 1
+// entries. Returns the total, or -1 (offsets filled up to the game that
+// didn't fit) if capacity is too small.
+CHESSCORE_API int chesscore_legal_moves_batch(ChessCoreGame* const* games, int count, uint16_t* moves, int capacity,
+                                              int* offsets);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
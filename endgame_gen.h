@@ -0,0 +1,215 @@
+#ifndef ENDGAME_GEN_H
+#define ENDGAME_GEN_H
+
+#include <thread>
+#include "Updatedchess.cpp"
+
+// Retrograde solver shared by chess_tb_gen and chess_bitbase_gen. It fills
+// one tablebase entry (see Tablebases) for every EndgameIndex position of a
+// material split, using ChessGame's move rules (including automatic queen
+// promotion) for every position.
+//
+// Pass k marks every position the side to move wins or loses in exactly k
+// plies before conversion; the passes read only earlier results, so threads
+// never race. Whatever is still open at the fixed point is a draw.
+
+// Entry of a position after a capture or promotion, which leaves the split:
+// takes the same arguments and gives the same result as Tablebases::probe
+// (-1 when no table covers it)
+typedef std::function<int(const char* pieces, const int* squares, int count, bool whiteToMove)> ConversionProbe;
+
+struct EndgameGenerator {
+    uint64_t key;
+    bool pawns;
+    int men;
+    int threadCount;
+    const ConversionProbe& probeConversion;
+    TablebasePosition layout;         // Men of the split, squares unset
+    std::vector<uint8_t> entries;
+    std::vector<uint64_t> resolved;   // One bit per entry that is final
+    std::atomic<bool> missingTable;
+
+    EndgameGenerator(uint64_t materialKey, int threads, const ConversionProbe& probe)
+        : key(materialKey), pawns(Tablebases::hasPawns(materialKey)), men(Tablebases::menCount(materialKey)),
+          threadCount(threads), probeConversion(probe), missingTable(false) {
+        std::string name = Tablebases::materialName(key);
+        layout.count = 2;
+        layout.pieces[0] = 'K';
+        layout.pieces[1] = 'k';
+        bool black = false;
+        for (size_t i = 1; i < name.size(); i++) {
+            if (name[i] == 'v') {
+                black = true;
+                i++;
+                continue;
+            }
+            layout.pieces[layout.count++] = black ? tolower(name[i]) : name[i];
+        }
+        layout.key = key;
+    }
+
+    bool isResolved(uint64_t idx) const {
+        return (resolved[idx >> 6] >> (idx & 63)) & 1;
+    }
+
+    void markResolved(uint64_t idx) {
+        resolved[idx >> 6] |= 1ULL << (idx & 63);
+    }
+
+    // The position an index stands for, in table order
+    void decode(uint64_t idx, TablebasePosition& position) const {
+        position = layout;
+        position.whiteToMove = EndgameIndex::decode(idx, men, pawns, position.squares);
+    }
+
+    void setupGame(ChessGame& game, const TablebasePosition& position) const {
+        std::string board(SIZE * SIZE, ' ');
+        for (int i = 0; i < position.count; i++) {
+            board[position.squares[i]] = position.pieces[i];
+        }
+        game.setBoardState(board, position.whiteToMove ? 'w' : 'b');
+    }
+
+    // A position is stored only under the index it mirrors to, with distinct
+    // squares, no pawns on the back ranks and the side not to move not in check
+    bool isValid(uint64_t idx, ChessGame& game) const {
+        TablebasePosition position;
+        decode(idx, position);
+        uint64_t occupied = 0;
+        for (int i = 0; i < men; i++) {
+            uint64_t bit = 1ULL << position.squares[i];
+            int row = position.squares[i] / SIZE;
+            if ((occupied & bit) || (toupper(position.pieces[i]) == 'P' && (row == 0 || row == SIZE - 1))) {
+                return false;
+            }
+            occupied |= bit;
+        }
+        if (Tablebases::index(position, pawns) != idx) {
+            return false;
+        }
+        setupGame(game, position);
+        return !game.isInCheck(position.whiteToMove ? 'b' : 'w');
+    }
+
+    // Entry of the position after a move, from the opponent's side: -1 while
+    // still open
+    int successor(const TablebasePosition& position, uint16_t move) {
+        int from = move & 63, to = (move >> 6) & 63;
+        char pieces[TB_MAX_PIECES];
+        int squares[TB_MAX_PIECES];
+        int count = 0;
+        bool converted = false;
+        for (int i = 0; i < position.count; i++) {
+            if (position.squares[i] == to) {
+                converted = true;   // Captured
+                continue;
+            }
+            pieces[count] = position.pieces[i];
+            squares[count] = (position.squares[i] == from) ? to : position.squares[i];
+            if (squares[count] == to && toupper(pieces[count]) == 'P' && (to / SIZE == 0 || to / SIZE == SIZE - 1)) {
+                pieces[count] = isupper(pieces[count]) ? 'Q' : 'q';
+                converted = true;
+            }
+            count++;
+        }
+
+        if (converted) {
+            int entry = probeConversion(pieces, squares, count, !position.whiteToMove);
+            if (entry < 0) missingTable = true;
+            return std::max(entry, 0);
+        }
+
+        TablebasePosition next;
+        Tablebases::normalize(pieces, squares, count, !position.whiteToMove, next);
+        uint64_t idx = Tablebases::index(next, pawns);
+        return isResolved(idx) ? entries[idx] : -1;
+    }
+
+    // 1 win, -1 loss, 0 still open after this pass
+    int solve(uint64_t idx, ChessGame& game) {
+        TablebasePosition position;
+        decode(idx, position);
+        setupGame(game, position);
+
+        uint16_t moves[MAX_MOVES];
+        int count = game.generateLegalMoves(moves);
+        bool allLost = true;
+        for (int m = 0; m < count; m++) {
+            int entry = successor(position, moves[m]);
+            if (entry >= 128) {
+                return 1;          // The opponent loses after this move
+            }
+            if (entry <= 0) {
+                allLost = false;   // A draw, or not known yet
+            }
+        }
+        return allLost ? -1 : 0;
+    }
+
+    // Run fn(begin, end, game, thread) over the index space on all threads
+    template <class Fn>
+    void parallelFor(uint64_t size, Fn fn) {
+        std::vector<std::thread> threads;
+        uint64_t chunk = ((size + threadCount - 1) / threadCount + 63) & ~63ULL;
+        for (int t = 0; t < threadCount; t++) {
+            uint64_t begin = std::min(size, t * chunk), end = std::min(size, begin + chunk);
+            threads.emplace_back([=, &fn]() {
+                ChessGame game;
+                fn(begin, end, game, t);
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Fills entries; false when a conversion has no table to look it up in
+    bool generate() {
+        uint64_t size = Tablebases::tableSize(men, pawns);
+        entries.assign(size, 0);
+        resolved.assign((size + 63) / 64, 0);
+        std::string name = Tablebases::materialName(key);
+
+        // Invalid slots stay draws; mates are losses at distance 0
+        parallelFor(size, [this](uint64_t begin, uint64_t end, ChessGame& game, int) {
+            for (uint64_t idx = begin; idx < end; idx++) {
+                if (!isValid(idx, game)) {
+                    markResolved(idx);
+                } else if (!game.hasLegalMoves(game.getCurrentPlayer())) {
+                    entries[idx] = game.isInCheckState() ? 128 : 0;
+                    markResolved(idx);
+                }
+            }
+        });
+
+        for (int pass = 1; ; pass++) {
+            std::vector<std::vector<std::pair<uint64_t, int>>> found(threadCount);
+            parallelFor(size, [this, &found](uint64_t begin, uint64_t end, ChessGame& game, int t) {
+                for (uint64_t idx = begin; idx < end; idx++) {
+                    if (isResolved(idx)) continue;
+                    int result = solve(idx, game);
+                    if (result != 0) found[t].push_back(std::make_pair(idx, result));
+                }
+            });
+            if (missingTable) {
+                std::cerr << name << ": a smaller table it converts into is missing" << std::endl;
+                return false;
+            }
+
+            size_t changed = 0;
+            int distance = std::min(pass, 127);
+            for (const auto& list : found) {
+                for (const auto& result : list) {
+                    entries[result.first] = result.second > 0 ? distance : 128 + distance;
+                    markResolved(result.first);
+                }
+                changed += list.size();
+            }
+            std::cerr << name << " pass " << pass << ": " << changed << " positions" << std::endl;
+            if (changed == 0) break;
+        }
+        return true;
+    }
+};
+
+#endif
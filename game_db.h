@@ -0,0 +1,310 @@
+#ifndef GAME_DB_H
+#define GAME_DB_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <thread>
+#include "Updatedchess.cpp"
+
+// Binary game database. One file holds, after a GameDbHeader:
+//   games     GameRecord per game (its slice of the move array and result)
+//   moves     every game's moves, packed as in ChessGame::encodeMove
+//   keys      PositionKey per distinct position hash, sorted by hash
+//   postings  ascending game IDs per key, each game listed once
+// Every position a game reached, its initial one included, is indexed, so
+// the games that reached a position are one binary search away and are
+// never replayed to find them.
+struct GameDbHeader {
+    char magic[4];
+    uint32_t reserved;
+    uint64_t gameCount;
+    uint64_t moveCount;
+    uint64_t keyCount;
+    uint64_t postingCount;
+};
+
+struct GameRecord {
+    uint64_t firstMove;
+    uint32_t plies;
+    uint8_t result;     // GameResult
+    uint8_t reserved[3];
+};
+
+enum GameResult { RESULT_UNKNOWN, RESULT_WHITE_WINS, RESULT_BLACK_WINS, RESULT_DRAW };
+
+struct PositionKey {
+    uint64_t key;
+    uint32_t firstPosting;
+    uint32_t postingCount;
+};
+
+// Read side: the whole file is mapped and queried in place
+class GameDatabase {
+private:
+    void* mapping;
+    size_t mappingLength;
+    const GameDbHeader* header;
+    const GameRecord* games;
+    const uint16_t* moves;
+    const PositionKey* keys;
+    const uint32_t* postings;
+
+public:
+    GameDatabase() : mapping(nullptr), mappingLength(0), header(nullptr) {}
+
+    ~GameDatabase() {
+        close();
+    }
+
+    bool open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        void* mapped = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(GameDbHeader)) {
+            mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+
+        // Sections follow each other; the move array is padded to 8 bytes
+        const GameDbHeader* h = (const GameDbHeader*)mapped;
+        uint64_t movesOffset = sizeof(GameDbHeader) + h->gameCount * sizeof(GameRecord);
+        uint64_t keysOffset = (movesOffset + h->moveCount * sizeof(uint16_t) + 7) & ~7ULL;
+        uint64_t postingsOffset = keysOffset + h->keyCount * sizeof(PositionKey);
+        if (memcmp(h->magic, "CGD1", 4) != 0 ||
+            (uint64_t)st.st_size != postingsOffset + h->postingCount * sizeof(uint32_t)) {
+            munmap(mapped, st.st_size);
+            return false;
+        }
+
+        mapping = mapped;
+        mappingLength = st.st_size;
+        header = h;
+        const char* base = (const char*)mapped;
+        games = (const GameRecord*)(base + sizeof(GameDbHeader));
+        moves = (const uint16_t*)(base + movesOffset);
+        keys = (const PositionKey*)(base + keysOffset);
+        postings = (const uint32_t*)(base + postingsOffset);
+        return true;
+    }
+
+    void close() {
+        if (mapping) {
+            munmap(mapping, mappingLength);
+        }
+        mapping = nullptr;
+        header = nullptr;
+    }
+
+    uint64_t gameCount() const {
+        return header ? header->gameCount : 0;
+    }
+
+    uint64_t positionCount() const {
+        return header ? header->keyCount : 0;
+    }
+
+    const GameRecord& game(uint32_t id) const {
+        return games[id];
+    }
+
+    const uint16_t* gameMoves(uint32_t id) const {
+        return moves + games[id].firstMove;
+    }
+
+    // IDs of every game that reached the position with this hash (see
+    // ChessGame::getHashKey), in ascending order; sets count
+    const uint32_t* findPosition(uint64_t key, uint32_t& count) const {
+        count = 0;
+        if (!header) {
+            return nullptr;
+        }
+        const PositionKey* end = keys + header->keyCount;
+        const PositionKey* found = std::lower_bound(keys, end, key,
+                                                    [](const PositionKey& entry, uint64_t k) { return entry.key < k; });
+        if (found == end || found->key != key) {
+            return nullptr;
+        }
+        count = found->postingCount;
+        return postings + found->firstPosting;
+    }
+
+    const uint32_t* findPosition(const ChessGame& position, uint32_t& count) const {
+        return findPosition(position.getHashKey(), count);
+    }
+
+    // Replay a stored game from the initial position. Returns false if its
+    // record or moves are corrupt (the game then holds the moves up to the
+    // bad one).
+    bool loadGame(uint32_t id, ChessGame& game) const {
+        game.initialize();
+        if (!header || id >= header->gameCount || games[id].firstMove > header->moveCount ||
+            games[id].plies > header->moveCount - games[id].firstMove) {
+            return false;
+        }
+        return game.replayTrusted(gameMoves(id), games[id].plies);
+    }
+};
+
+// Write side: replays raw move histories (getRawMoveHistory format) on
+// ChessGame across threads, checking every move, and writes the database
+// in one go
+class GameDatabaseBuilder {
+private:
+    struct Posting {
+        uint64_t key;
+        uint32_t game;
+
+        bool operator<(const Posting& other) const {
+            return key != other.key ? key < other.key : game < other.game;
+        }
+        bool operator==(const Posting& other) const {
+            return key == other.key && game == other.game;
+        }
+    };
+
+    std::vector<std::string> histories;
+    std::vector<uint8_t> results;
+
+    // Replay games [begin, end): their packed moves into moves[game] and
+    // every position reached into postings. A game with a malformed or
+    // illegal move is left out, with the move recorded in badMoves[game].
+    void replayRange(size_t begin, size_t end, std::vector<std::vector<uint16_t>>& moves,
+                     std::vector<Posting>& postings, std::vector<std::string>& badMoves) const {
+        ChessGame game;
+        for (size_t id = begin; id < end; id++) {
+            game.initialize();
+            size_t first = postings.size();
+            postings.push_back({game.getHashKey(), (uint32_t)id});
+            const std::string& raw = histories[id];
+            for (size_t pos = 0; pos < raw.size(); pos++) {
+                size_t comma = std::min(raw.find(',', pos), raw.size());
+                uint16_t move;
+                if (!game.parseSAN(raw.c_str() + pos, comma - pos, move)) {
+                    badMoves[id] = comma > pos ? raw.substr(pos, comma - pos) : "(empty)";
+                    break;
+                }
+                game.replayTrusted(&move, 1);
+                moves[id].push_back(move);
+                postings.push_back({game.getHashKey(), (uint32_t)id});
+                pos = comma;
+            }
+            if (!badMoves[id].empty()) {
+                moves[id].clear();
+                postings.resize(first);
+                continue;
+            }
+
+            // A game that repeats a position is listed for it once
+            std::sort(postings.begin() + first, postings.end());
+            postings.erase(std::unique(postings.begin() + first, postings.end()), postings.end());
+        }
+        std::sort(postings.begin(), postings.end());
+    }
+
+    // An empty vector may have no storage, so it is not passed to fwrite
+    template <class T>
+    static bool writeArray(FILE* file, const std::vector<T>& values) {
+        return values.empty() || fwrite(values.data(), sizeof(T), values.size(), file) == values.size();
+    }
+
+public:
+    // raw is in getRawMoveHistory format, from the initial position
+    void addGame(const std::string& raw, uint8_t result) {
+        histories.push_back(raw);
+        results.push_back(result);
+    }
+
+    size_t size() const {
+        return histories.size();
+    }
+
+    // Replay and write every added game. Games that don't replay are
+    // skipped; badMoves[i] is the offending move of added game i, or empty.
+    // Game IDs in the file number only the games kept.
+    bool write(const char* path, int threadCount, std::vector<std::string>& badMoves) const {
+        size_t added = histories.size();
+        std::vector<std::vector<uint16_t>> moves(added);
+        std::vector<std::vector<Posting>> postings(threadCount);
+        badMoves.assign(added, std::string());
+        std::vector<std::thread> threads;
+        size_t chunk = (added + threadCount - 1) / threadCount;
+        for (int t = 0; t < threadCount; t++) {
+            size_t begin = std::min(added, t * chunk), end = std::min(added, begin + chunk);
+            threads.emplace_back([this, begin, end, &moves, &postings, &badMoves, t]() {
+                replayRange(begin, end, moves, postings[t], badMoves);
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        // Number the games kept, in input order
+        std::vector<uint32_t> gameId(added);
+        size_t count = 0;
+        for (size_t i = 0; i < added; i++) {
+            gameId[i] = (uint32_t)count;
+            count += badMoves[i].empty();
+        }
+
+        // Merge the sorted per-thread runs into keys and postings
+        std::vector<PositionKey> keyTable;
+        std::vector<uint32_t> gameIds;
+        std::vector<size_t> cursor(threadCount, 0);
+        while (true) {
+            int best = -1;
+            for (int t = 0; t < threadCount; t++) {
+                if (cursor[t] < postings[t].size() &&
+                    (best < 0 || postings[t][cursor[t]] < postings[best][cursor[best]])) {
+                    best = t;
+                }
+            }
+            if (best < 0) break;
+            const Posting& next = postings[best][cursor[best]++];
+            if (keyTable.empty() || keyTable.back().key != next.key) {
+                keyTable.push_back({next.key, (uint32_t)gameIds.size(), 0});
+            }
+            keyTable.back().postingCount++;
+            gameIds.push_back(gameId[next.game]);
+        }
+
+        std::vector<GameRecord> records;
+        records.reserve(count);
+        uint64_t moveCount = 0;
+        for (size_t i = 0; i < added; i++) {
+            if (badMoves[i].empty()) {
+                records.push_back({moveCount, (uint32_t)moves[i].size(), results[i], {0, 0, 0}});
+                moveCount += moves[i].size();
+            }
+        }
+
+        FILE* file = fopen(path, "wb");
+        if (!file) {
+            return false;
+        }
+        GameDbHeader header = {};
+        memcpy(header.magic, "CGD1", 4);
+        header.gameCount = count;
+        header.moveCount = moveCount;
+        header.keyCount = keyTable.size();
+        header.postingCount = gameIds.size();
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && writeArray(file, records);
+        for (size_t i = 0; ok && i < added; i++) {
+            ok = writeArray(file, moves[i]);
+        }
+        static const char padding[8] = {0};
+        size_t pad = (8 - (moveCount * sizeof(uint16_t)) % 8) % 8;
+        ok = ok && fwrite(padding, 1, pad, file) == pad && writeArray(file, keyTable) && writeArray(file, gameIds);
+        return fclose(file) == 0 && ok;
+    }
+};
+
+#endif
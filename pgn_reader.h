@@ -0,0 +1,268 @@
+#ifndef PGN_READER_H
+#define PGN_READER_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Updatedchess.cpp"
+
+// A view into the mapped PGN file; tokens are never copied
+struct PgnToken {
+    const char* text;
+    size_t length;
+
+    bool equals(const char* s) const {
+        return length == strlen(s) && memcmp(text, s, length) == 0;
+    }
+};
+
+// Tags and outcome of the game most recently returned by PgnReader
+struct PgnGameInfo {
+    std::vector<std::pair<PgnToken, PgnToken>> tags; // Reused between games
+    PgnToken result;
+    size_t plies;
+    bool setUp;         // Started from its FEN tag, not the initial position
+    bool malformed;
+    PgnToken badToken;  // First move that failed to resolve
+    const char* reason;
+};
+
+// Multi-game PGN reader over a memory-mapped file. Moves are resolved with
+// ChessGame::parseSAN and applied with replayTrusted, since resolution has
+// already checked them against the legal move list. Malformed games are
+// reported through PgnGameInfo and skipped to their end, never aborting the
+// rest of the file.
+class PgnReader {
+private:
+    const char* data;
+    size_t size;
+    size_t pos;
+    int fd;
+
+    void skipSpaceAndComments() {
+        while (pos < size) {
+            char ch = data[pos];
+            if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+                pos++;
+            } else if (ch == '{') {
+                // Brace comment, runs to the closing brace
+                while (pos < size && data[pos] != '}') pos++;
+                pos++;
+            } else if (ch == ';' || (ch == '%' && (pos == 0 || data[pos - 1] == '\n'))) {
+                // Rest-of-line comment or escape line
+                while (pos < size && data[pos] != '\n') pos++;
+            } else {
+                return;
+            }
+        }
+    }
+
+    // Skip a (possibly nested) recursive annotation variation
+    void skipVariation() {
+        int depth = 0;
+        while (pos < size) {
+            skipSpaceAndComments();
+            if (pos >= size) return;
+            if (data[pos] == '(') {
+                depth++;
+            } else if (data[pos] == ')') {
+                depth--;
+                if (depth == 0) {
+                    pos++;
+                    return;
+                }
+            }
+            pos++;
+        }
+    }
+
+    // Read a [Name "Value"] tag pair; pos is on the opening bracket
+    bool readTag(PgnToken& name, PgnToken& value) {
+        pos++;
+        while (pos < size && (data[pos] == ' ' || data[pos] == '\t')) pos++;
+        name.text = data + pos;
+        while (pos < size && data[pos] != ' ' && data[pos] != '"' && data[pos] != ']') pos++;
+        name.length = data + pos - name.text;
+
+        while (pos < size && data[pos] != '"' && data[pos] != ']' && data[pos] != '\n') pos++;
+        if (pos >= size || data[pos] != '"') {
+            while (pos < size && data[pos] != '\n') pos++;
+            return false;
+        }
+        pos++;
+        value.text = data + pos;
+        while (pos < size && data[pos] != '"' && data[pos] != '\n') {
+            if (data[pos] == '\\' && pos + 1 < size) pos++;
+            pos++;
+        }
+        value.length = data + pos - value.text;
+        while (pos < size && data[pos] != ']' && data[pos] != '\n') pos++;
+        if (pos < size && data[pos] == ']') pos++;
+        return true;
+    }
+
+    // Read one movetext symbol (move, move number, NAG or result)
+    PgnToken readSymbol() {
+        PgnToken token;
+        token.text = data + pos;
+        while (pos < size) {
+            char ch = data[pos];
+            if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' ||
+                ch == '{' || ch == '(' || ch == ')' || ch == '[' || ch == ';') {
+                break;
+            }
+            pos++;
+        }
+        token.length = data + pos - token.text;
+        return token;
+    }
+
+    static bool isResult(const PgnToken& token) {
+        return token.equals("1-0") || token.equals("0-1") || token.equals("1/2-1/2") || token.equals("*");
+    }
+
+public:
+    PgnReader() : data(nullptr), size(0), pos(0), fd(-1) {}
+
+    ~PgnReader() {
+        close();
+    }
+
+    bool open(const char* path) {
+        close();
+        fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close();
+            return false;
+        }
+        size = (size_t)st.st_size;
+        if (size > 0) {
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close();
+                return false;
+            }
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            data = (const char*)mapped;
+        }
+        return true;
+    }
+
+    void close() {
+        if (data) {
+            munmap((void*)data, size);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        data = nullptr;
+        size = 0;
+        pos = 0;
+        fd = -1;
+    }
+
+    // Bytes consumed so far, for progress reporting
+    size_t offset() const {
+        return pos;
+    }
+
+    // Parse the next game into game (reinitialized first, or set up from
+    // its FEN tag). Returns false at end of file. A game whose moves don't resolve comes back with
+    // info.malformed set and the moves up to the bad one applied.
+    bool nextGame(ChessGame& game, PgnGameInfo& info) {
+        game.initialize();
+        info.tags.clear();
+        info.result.text = "*";
+        info.result.length = 1;
+        info.plies = 0;
+        info.setUp = false;
+        info.malformed = false;
+        info.badToken.text = "";
+        info.badToken.length = 0;
+        info.reason = "";
+
+        bool started = false;
+        bool inMovetext = false;
+
+        while (true) {
+            skipSpaceAndComments();
+            if (pos >= size) {
+                return started;
+            }
+
+            char ch = data[pos];
+            if (ch == '[') {
+                // A tag after movetext starts the next game (missing result)
+                if (inMovetext) {
+                    return true;
+                }
+                PgnToken name, value;
+                if (readTag(name, value)) {
+                    info.tags.push_back(std::make_pair(name, value));
+                    if (name.equals("FEN") && !info.malformed) {
+                        info.setUp = game.loadFEN(std::string(value.text, value.length));
+                        if (!info.setUp) {
+                            info.malformed = true;
+                            info.reason = "invalid FEN tag";
+                        }
+                    }
+                }
+                started = true;
+                continue;
+            }
+            if (ch == '(') {
+                skipVariation();
+                continue;
+            }
+            if (ch == ')') {
+                pos++;
+                continue;
+            }
+
+            started = true;
+            inMovetext = true;
+            PgnToken token = readSymbol();
+            if (token.length == 0) {
+                pos++;
+                continue;
+            }
+
+            if (isResult(token)) {
+                info.result = token;
+                return true;
+            }
+            if (token.text[0] == '$') {
+                continue;
+            }
+
+            // Move numbers ("12.", "12...") may be glued to the move ("12.e4")
+            size_t skip = 0;
+            while (skip < token.length && (isdigit((unsigned char)token.text[skip]) || token.text[skip] == '.')) {
+                skip++;
+            }
+            token.text += skip;
+            token.length -= skip;
+            if (token.length == 0 || info.malformed) {
+                continue;
+            }
+
+            uint16_t move;
+            if (game.parseSAN(token.text, token.length, move)) {
+                game.replayTrusted(&move, 1);
+                info.plies++;
+            } else {
+                info.malformed = true;
+                info.badToken = token;
+                info.reason = (token.text[0] == 'O') ? "castling is not supported" : "unresolvable move";
+            }
+        }
+    }
+};
+
+#endif